@@ -0,0 +1,186 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef ANOMALY_DETECTOR_HPP
+#define ANOMALY_DETECTOR_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+
+// Settings of the anomaly detection. The defaults suit the tempering
+// sensors: readings of 30 to 32 degrees are normal, 33 is a spike.
+struct AnomalySettings {
+    AnomalySettings()
+            : alpha(0.01),
+              enter_z(2.25),
+              exit_z(1.5),
+              drift_alpha(0.001),
+              drift_enter(1.0),
+              drift_exit(0.5),
+              warmup_count(50),
+              min_stddev(0.25)
+    {
+    }
+
+    // Weight of each reading in the baseline: it follows the last 1 / alpha
+    // readings or so
+    double alpha;
+    // A reading starts an anomaly when its z-score is this high, and the
+    // anomaly ends with the first reading under exit_z
+    double enter_z;
+    double exit_z;
+    // Weight of each reading in the long-term baseline. Drift is the
+    // distance between the two means, in standard deviations: it starts an
+    // anomaly at drift_enter, which ends under drift_exit.
+    double drift_alpha;
+    double drift_enter;
+    double drift_exit;
+    // Readings that make the baseline before anything is reported
+    uint32_t warmup_count;
+    // The z-scores of a sensor whose readings barely change use this
+    // standard deviation, so that small changes are not anomalies
+    double min_stddev;
+};
+
+enum class AnomalyEvent {
+    none,  // Same state as the previous reading
+    started,  // The reading is far from the baseline
+    ended  // The readings are back to the baseline
+};
+
+// Baseline of one sensor: the exponentially weighted moving mean and variance
+// of its readings. Each reading is compared to the baseline of the readings
+// before it, then added to it, so spikes and steps stand out. The baseline
+// follows a slow drift, which is found by comparing its mean with a
+// long-term mean that lags further behind.
+class EwmaDetector {
+public:
+    EwmaDetector()
+            : mean(0),
+              variance(0),
+              long_term_mean(0),
+              count(0),
+              anomalous(false)
+    {
+    }
+
+    AnomalyEvent update(
+            double value,
+            const AnomalySettings& settings,
+            double& z_score)
+    {
+        double deviation = value - mean;
+        double stddev = std::sqrt(variance);
+        if (stddev < settings.min_stddev) {
+            stddev = settings.min_stddev;
+        }
+        z_score = count > 0 ? deviation / stddev : 0;
+        double drift = std::fabs(mean - long_term_mean) / stddev;
+
+        AnomalyEvent event = AnomalyEvent::none;
+        if (count >= settings.warmup_count) {
+            double magnitude = std::fabs(z_score);
+            if (!anomalous
+                && (magnitude >= settings.enter_z
+                    || drift >= settings.drift_enter)) {
+                anomalous = true;
+                event = AnomalyEvent::started;
+            } else if (
+                    anomalous && magnitude < settings.exit_z
+                    && drift < settings.drift_exit) {
+                anomalous = false;
+                event = AnomalyEvent::ended;
+            }
+        }
+
+        // During the warmup the weight is 1 / count, so the baseline is the
+        // plain mean and variance of the first readings
+        count = count < UINT32_MAX ? count + 1 : count;
+        double weight = 1.0 / count;
+        if (weight < settings.alpha) {
+            weight = settings.alpha;
+        }
+        mean += weight * deviation;
+        variance = (1 - weight) * (variance + weight * deviation * deviation);
+        double long_term_weight = 1.0 / count;
+        if (long_term_weight < settings.drift_alpha) {
+            long_term_weight = settings.drift_alpha;
+        }
+        long_term_mean += long_term_weight * (value - long_term_mean);
+        return event;
+    }
+
+    double baseline_mean() const
+    {
+        return mean;
+    }
+
+    double baseline_stddev() const
+    {
+        return std::sqrt(variance);
+    }
+
+    double long_term_baseline_mean() const
+    {
+        return long_term_mean;
+    }
+
+    bool in_anomaly() const
+    {
+        return anomalous;
+    }
+
+private:
+    double mean;
+    double variance;
+    double long_term_mean;
+    uint32_t count;
+    bool anomalous;
+};
+
+// An EwmaDetector per sensor, 32 bytes each. Memory is only allocated for
+// the first reading of a sensor.
+template <typename Key>
+class AnomalyDetector {
+public:
+    explicit AnomalyDetector(const AnomalySettings& settings = AnomalySettings())
+            : settings(settings)
+    {
+    }
+
+    // Compares a reading with the baseline of its sensor, and adds it to the
+    // baseline. z_score is how many standard deviations it is from the mean.
+    AnomalyEvent update(const Key& key, double value, double& z_score)
+    {
+        return sensors[key].update(value, settings, z_score);
+    }
+
+    // Returns the baseline of a sensor, or nullptr if it has no readings
+    const EwmaDetector *find(const Key& key) const
+    {
+        auto it = sensors.find(key);
+        return it == sensors.end() ? nullptr : &it->second;
+    }
+
+    // Forgets a sensor, for example when its instance is disposed
+    void remove(const Key& key)
+    {
+        sensors.erase(key);
+    }
+
+private:
+    AnomalySettings settings;
+    std::map<Key, EwmaDetector> sensors;
+};
+
+#endif  // ANOMALY_DETECTOR_HPP
@@ -0,0 +1,158 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "application.hpp"  // Argument parsing
+#include "anomaly_detector.hpp"  // EWMA anomaly detection
+#include "benchmark.hpp"  // Stopwatch and result printing
+
+using namespace application;
+
+// Anomaly detector benchmark:
+// 1) Cost of an update, with the readings of 1, 50 and 1000 sensors
+// 2) Detection latency: readings from the start of a spike, a step and
+//    ramps until the detector reports the anomaly, and false anomalies
+//
+// The normal readings are those of the tempering application: 30 to 32
+// degrees. No DDS entities are created: this measures the detector alone.
+//
+// -s, --sample-count sets how many readings are processed per test.
+
+const unsigned int DEFAULT_SAMPLE_COUNT = 10000000;
+
+// Normal readings before each latency test, to make the baseline
+const unsigned int BASELINE_READINGS = 5000;
+
+// Readings after which an anomaly counts as missed
+const unsigned int MAX_LATENCY_READINGS = 100000;
+
+int32_t normal_reading()
+{
+    return rand() % 3 + 30;
+}
+
+void benchmark_update_cost(uint32_t sensor_count, unsigned int sample_count)
+{
+    // The readings are generated first, so that only the updates are timed
+    std::vector<int32_t> readings(sample_count);
+    for (auto& reading : readings) {
+        reading = normal_reading();
+    }
+
+    AnomalyDetector<uint32_t> detector;
+    unsigned int anomaly_count = 0;
+    double z_score = 0;
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int i = 0; i < sample_count && !shutdown_requested; i++) {
+        if (detector.update(i % sensor_count, readings[i], z_score)
+            == AnomalyEvent::started) {
+            anomaly_count++;
+        }
+    }
+    benchmark::print_result(
+            "Update, " + std::to_string(sensor_count) + " sensors",
+            sample_count,
+            stopwatch.elapsed_seconds());
+    std::cout << "    false anomalies: " << anomaly_count << std::endl;
+}
+
+// Feeds normal readings, then the readings returned by reading(n, normal)
+// for the nth reading, and prints how many readings it takes to detect the
+// anomaly
+template <typename Reading>
+void benchmark_latency(const std::string& label, Reading reading)
+{
+    AnomalyDetector<uint32_t> detector;
+    double z_score = 0;
+    unsigned int false_anomalies = 0;
+    for (unsigned int i = 0; i < BASELINE_READINGS; i++) {
+        if (detector.update(0, normal_reading(), z_score)
+            == AnomalyEvent::started) {
+            false_anomalies++;
+        }
+    }
+
+    unsigned int latency = 0;
+    double value = 0;
+    for (; latency < MAX_LATENCY_READINGS; latency++) {
+        value = reading(latency, normal_reading());
+        if (detector.update(0, value, z_score) == AnomalyEvent::started) {
+            break;
+        }
+    }
+
+    std::cout << std::left << std::setw(44) << label << std::right;
+    if (latency < MAX_LATENCY_READINGS) {
+        std::cout << "detected after " << latency << " readings, at "
+                  << std::setprecision(2) << value << " degrees";
+    } else {
+        std::cout << "not detected";
+    }
+    std::cout << ", false anomalies before: " << false_anomalies << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    // The sample count defaults to infinite, use a finite number of samples
+    unsigned int sample_count = arguments.sample_count
+                    == (std::numeric_limits<unsigned int>::max)()
+            ? DEFAULT_SAMPLE_COUNT
+            : arguments.sample_count;
+
+    std::cout << "Benchmarking " << sample_count << " readings per test"
+              << std::endl;
+    const uint32_t sensor_counts[] = { 1, 50, 1000 };
+    for (uint32_t sensor_count : sensor_counts) {
+        benchmark_update_cost(sensor_count, sample_count);
+    }
+
+    std::cout << std::endl << "Detection latency:" << std::endl;
+    // The spike of the tempering application: one reading of 33 degrees
+    benchmark_latency(
+            "Spike of one reading",
+            [](unsigned int n, int32_t normal) {
+                return n == 0 ? 33.0 : normal;
+            });
+    benchmark_latency("Step of +2 degrees", [](unsigned int, int32_t normal) {
+        return normal + 2.0;
+    });
+    // Ramps slower than about 0.001 degrees per reading are followed by the
+    // long-term baseline too, and are not anomalies
+    const double ramp_rates[] = { 0.01, 0.002, 0.0005 };
+    for (double rate : ramp_rates) {
+        std::ostringstream label;
+        label << "Ramp of " << rate << " degrees per reading";
+        benchmark_latency(label.str(), [rate](unsigned int n, int32_t normal) {
+            return normal + rate * n;
+        });
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -13,11 +13,21 @@
 #ifndef APPLICATION_HPP
 #define APPLICATION_HPP
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <csignal>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 #include <dds/core/ddscore.hpp>
+#include <dds/domain/ddsdomain.hpp>
 
 
 namespace application {
@@ -37,12 +47,372 @@ inline void setup_signal_handlers()
     signal(SIGTERM, stop_handler);
 }
 
+// Levels of the log messages, from the most to the least important
+enum class LogLevel {
+    error,
+    warning,
+    info,
+    debug
+};
+
+// Messages less important than this level are not logged, and the code that
+// copies them is removed at compile time. Their arguments are still
+// evaluated, so they should be cheap: literals, numbers and fixed-size
+// copies. For example, -DAPPLICATION_LOG_LEVEL=1 keeps only errors and
+// warnings.
+#ifndef APPLICATION_LOG_LEVEL
+    #define APPLICATION_LOG_LEVEL 3
+#endif
+
+// Asynchronous log for the data paths of the applications. Logging a message
+// copies its arguments into a ring buffer of the calling thread, without
+// locking, formatting or flushing. A writer thread formats the messages of
+// every ring, and flushes once per batch.
+//
+// The messages of a thread are written in order, but those of different
+// threads may be interleaved in another order. When the ring of a thread is
+// full, its messages are dropped and counted, so logging never blocks.
+// const char* arguments must point to string literals, or other static
+// storage: only the pointer is copied.
+class AsyncLog {
+public:
+    // Bytes for the arguments of a message: a formatted Temperature and a
+    // few numbers
+    static const size_t ARGUMENTS_SIZE = 128;
+    // Messages in the ring of each thread
+    static const size_t RING_CAPACITY = 4096;
+
+    static AsyncLog& instance()
+    {
+        static AsyncLog log;
+        return log;
+    }
+
+    bool enabled(LogLevel level) const
+    {
+        return static_cast<int>(level) <= APPLICATION_LOG_LEVEL
+                && level <= runtime_level.load(std::memory_order_relaxed);
+    }
+
+    void level(LogLevel level)
+    {
+        runtime_level.store(level, std::memory_order_relaxed);
+    }
+
+    // Copies the arguments for the writer thread, or writes them at once if
+    // it is not running
+    template <typename... Args>
+    void write(Args&&... args)
+    {
+        typedef std::tuple<typename std::decay<Args>::type...> Arguments;
+        static_assert(
+                sizeof(Arguments) <= ARGUMENTS_SIZE
+                        && alignof(Arguments) <= alignof(ArgumentStorage),
+                "Too many or too large log message arguments");
+
+        if (!running.load(std::memory_order_acquire)) {
+            print(std::cout, std::tie(args...));
+            std::cout << std::endl;
+            return;
+        }
+        Ring& ring = thread_ring();
+        Record *record = ring.begin_push();
+        if (record == nullptr) {
+            return;
+        }
+        new (&record->arguments) Arguments(std::forward<Args>(args)...);
+        record->print = &print_record<Arguments>;
+        ring.end_push();
+    }
+
+    // Starts the writer thread. Messages are written to output.
+    void start(std::ostream& output)
+    {
+        if (running.exchange(true)) {
+            return;
+        }
+        out = &output;
+        writer = std::thread(&AsyncLog::write_messages, this);
+    }
+
+    // Stops the writer thread, after it has written the pending messages
+    void stop()
+    {
+        if (!running.exchange(false)) {
+            return;
+        }
+        writer.join();
+        drain();
+    }
+
+    // Waits until the writer thread has written the messages logged so far
+    // by the calling thread
+    void flush()
+    {
+        if (!running.load(std::memory_order_acquire)) {
+            return;
+        }
+        Ring& ring = thread_ring();
+        uint64_t last = ring.head.load(std::memory_order_relaxed);
+        while (ring.tail.load(std::memory_order_acquire) < last
+               && running.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    // Messages dropped because the ring of their thread was full
+    uint64_t dropped() const
+    {
+        return dropped_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    typedef std::aligned_storage<ARGUMENTS_SIZE>::type ArgumentStorage;
+
+    struct Record {
+        // Prints the arguments, and destroys them
+        void (*print)(void *arguments, std::ostream& out);
+        ArgumentStorage arguments;
+    };
+
+    // Single-producer, single-consumer ring: the thread that owns it pushes,
+    // and the writer thread pops
+    class Ring {
+    public:
+        Ring()
+                : records(RING_CAPACITY),
+                  head(0),
+                  tail(0),
+                  dropped(0),
+                  closed(false)
+        {
+        }
+
+        // Returns the record to fill in, or nullptr if the ring is full
+        Record *begin_push()
+        {
+            uint64_t next = head.load(std::memory_order_relaxed);
+            if (next - tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return &records[next % RING_CAPACITY];
+        }
+
+        // Publishes the record returned by begin_push() to the writer
+        void end_push()
+        {
+            head.store(
+                    head.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+        }
+
+        // Writes the records pushed so far, and returns how many
+        size_t pop_all(std::ostream& out)
+        {
+            uint64_t first = tail.load(std::memory_order_relaxed);
+            uint64_t last = head.load(std::memory_order_acquire);
+            for (uint64_t next = first; next != last; next++) {
+                Record& record = records[next % RING_CAPACITY];
+                record.print(&record.arguments, out);
+                out << '\n';
+                tail.store(next + 1, std::memory_order_release);
+            }
+            return static_cast<size_t>(last - first);
+        }
+
+        std::vector<Record> records;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::atomic<uint64_t> dropped;
+        // Set when the thread exits: the ring is removed once empty
+        std::atomic<bool> closed;
+    };
+
+    // Creates the ring of a thread, and closes it when the thread exits
+    struct RingOwner {
+        explicit RingOwner(AsyncLog& log) : ring(std::make_shared<Ring>())
+        {
+            std::lock_guard<std::mutex> lock(log.rings_mutex);
+            log.rings.push_back(ring);
+        }
+
+        ~RingOwner()
+        {
+            ring->closed.store(true, std::memory_order_release);
+        }
+
+        std::shared_ptr<Ring> ring;
+    };
+
+    AsyncLog()
+            : runtime_level(LogLevel::info),
+              running(false),
+              out(&std::cout),
+              dropped_count(0)
+    {
+    }
+
+    ~AsyncLog()
+    {
+        stop();
+    }
+
+    Ring& thread_ring()
+    {
+        static thread_local RingOwner owner(*this);
+        return *owner.ring;
+    }
+
+    template <size_t Index, size_t Count>
+    struct TuplePrinter {
+        template <typename Tuple>
+        static void print(std::ostream& out, const Tuple& arguments)
+        {
+            out << std::get<Index>(arguments);
+            TuplePrinter<Index + 1, Count>::print(out, arguments);
+        }
+    };
+
+    template <size_t Count>
+    struct TuplePrinter<Count, Count> {
+        template <typename Tuple>
+        static void print(std::ostream&, const Tuple&)
+        {
+        }
+    };
+
+    template <typename Tuple>
+    static void print(std::ostream& out, const Tuple& arguments)
+    {
+        TuplePrinter<0, std::tuple_size<Tuple>::value>::print(out, arguments);
+    }
+
+    template <typename Arguments>
+    static void print_record(void *storage, std::ostream& out)
+    {
+        Arguments *arguments = static_cast<Arguments *>(storage);
+        print(out, *arguments);
+        arguments->~Arguments();
+    }
+
+    // Writes the messages of every ring, and the number of messages dropped.
+    // Returns how many messages were written.
+    size_t drain()
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        size_t count = 0;
+        uint64_t dropped = 0;
+        for (auto it = rings.begin(); it != rings.end();) {
+            // A closed ring gets no more messages once drained
+            bool closed = (*it)->closed.load(std::memory_order_acquire);
+            count += (*it)->pop_all(*out);
+            dropped += (*it)->dropped.exchange(0, std::memory_order_relaxed);
+            it = closed ? rings.erase(it) : it + 1;
+        }
+        if (dropped > 0) {
+            dropped_count.fetch_add(dropped, std::memory_order_relaxed);
+            *out << "[" << dropped << " log messages dropped]\n";
+        }
+        if (count > 0 || dropped > 0) {
+            out->flush();
+        }
+        return count;
+    }
+
+    void write_messages()
+    {
+        while (running.load(std::memory_order_acquire)) {
+            if (drain() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    std::atomic<LogLevel> runtime_level;
+    std::atomic<bool> running;
+    std::ostream *out;
+    std::thread writer;
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::atomic<uint64_t> dropped_count;
+};
+
+// Logs a message made of the arguments, printed one after the other with
+// operator<<, if its level is enabled
+template <typename... Args>
+inline void log_message(LogLevel level, Args&&... args)
+{
+    AsyncLog& log = AsyncLog::instance();
+    if (log.enabled(level)) {
+        log.write(std::forward<Args>(args)...);
+    }
+}
+
+// Runs the writer thread of the log while it exists. Its destructor writes
+// the messages that are still pending.
+class LogWriter {
+public:
+    explicit LogWriter(LogLevel level, std::ostream& out = std::cout)
+    {
+        AsyncLog::instance().level(level);
+        AsyncLog::instance().start(out);
+    }
+
+    ~LogWriter()
+    {
+        AsyncLog::instance().stop();
+    }
+};
+
+// Writes the log messages to out while it exists, for example to a
+// dashboard, and to the standard output again when destroyed
+class LogRedirect {
+public:
+    explicit LogRedirect(std::ostream& out)
+    {
+        AsyncLog::instance().stop();
+        AsyncLog::instance().start(out);
+    }
+
+    ~LogRedirect()
+    {
+        AsyncLog::instance().stop();
+        AsyncLog::instance().start(std::cout);
+    }
+};
+
+// Reads a -l, --log-level value. Returns false if it is not valid.
+inline bool log_level_from_string(const std::string& name, LogLevel& level)
+{
+    if (name == "error") {
+        level = LogLevel::error;
+    } else if (name == "warning") {
+        level = LogLevel::warning;
+    } else if (name == "info") {
+        level = LogLevel::info;
+    } else if (name == "debug") {
+        level = LogLevel::debug;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 enum class ParseReturn {
     ok,
     failure,
     exit
 };
 
+// How the monitoring application handles temperature readings that arrive
+// faster than it processes them
+enum class CoalesceMode {
+    none,  // Process every reading, in order
+    qos,  // DataReader keeps only the newest reading per sensor: KEEP_LAST 1
+    table  // Application keeps only the newest reading per sensor
+};
+
 struct ApplicationArguments {
     ParseReturn parse_result;
     unsigned int domain_id;
@@ -50,8 +420,71 @@ struct ApplicationArguments {
     std::string sensor_id;
     rti::config::Verbosity verbosity;
     std::string station_kind;
+    std::string transport;
+    CoalesceMode coalesce_mode;
+    unsigned int summary_window_millisec;
+    bool use_summaries;
+    unsigned int flow_rate;
+    unsigned int flow_burst;
+    unsigned int bulk_lots;
+    bool use_custom_filter;
+    unsigned int statistics_period_sec;
+    bool all_temperatures;
+    std::string snapshot_file;
+    unsigned int dashboard_refresh_millisec;
+    LogLevel log_level;
+    std::string recording_directory;
+    unsigned int segment_size_mb;
+    double replay_speed;
+    unsigned int replica_count;
+    std::string archive_directory;
+    std::string archive_query;
 };
 
+// Returns the name of the QoS profile that selects the transports for a
+// -t, --transport value. Returns an empty string for "default", and for
+// values that are not valid.
+inline std::string transport_profile_name(const std::string& transport)
+{
+    if (transport == "shmem") {
+        return "ChocolateFactoryLibrary::Transport.SharedMemory";
+    } else if (transport == "udp") {
+        return "ChocolateFactoryLibrary::Transport.UDPv4Loopback";
+    } else if (transport == "both") {
+        return "ChocolateFactoryLibrary::Transport.SharedMemoryAndUDPv4";
+    }
+    return "";
+}
+
+// Loads the DomainParticipant QoS of an application profile, and applies the
+// transport settings of the profile selected with -t, --transport on top of it
+inline dds::domain::qos::DomainParticipantQos participant_qos_with_transport(
+        dds::core::QosProvider& qos_provider,
+        const std::string& profile,
+        const std::string& transport)
+{
+    using namespace rti::core::policy;
+
+    dds::domain::qos::DomainParticipantQos qos =
+            qos_provider.participant_qos(profile);
+    std::string transport_profile = transport_profile_name(transport);
+    if (transport_profile.empty()) {
+        return qos;
+    }
+
+    dds::domain::qos::DomainParticipantQos transport_qos =
+            qos_provider.participant_qos(transport_profile);
+    qos << transport_qos.policy<TransportBuiltin>();
+    qos << transport_qos.policy<Discovery>();
+    // Keep the properties of the application profile, add the transport ones
+    Property& property = qos.policy<Property>();
+    for (const auto& entry : transport_qos.policy<Property>().get_all()) {
+        property.set(entry);
+    }
+
+    return qos;
+}
+
 // Parses application arguments for example.
 inline ApplicationArguments parse_arguments(int argc, char *argv[])
 {
@@ -63,6 +496,25 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
     srand((unsigned int)time(NULL));
     std::string sensor_id = std::to_string(rand() % 50);
     std::string station_kind("COCOA_BUTTER_CONTROLLER");
+    std::string transport("default");
+    CoalesceMode coalesce_mode = CoalesceMode::none;
+    unsigned int summary_window_millisec = 1000;
+    bool use_summaries = false;
+    unsigned int flow_rate = 0;
+    unsigned int flow_burst = 100;
+    unsigned int bulk_lots = 0;
+    bool use_custom_filter = false;
+    unsigned int statistics_period_sec = 0;
+    bool all_temperatures = false;
+    std::string snapshot_file;
+    unsigned int dashboard_refresh_millisec = 0;
+    LogLevel log_level = LogLevel::info;
+    std::string recording_directory("recording");
+    unsigned int segment_size_mb = 64;
+    double replay_speed = 1.0;
+    unsigned int replica_count = 1;
+    std::string archive_directory("archive");
+    std::string archive_query;
     rti::config::Verbosity verbosity = rti::config::Verbosity::EXCEPTION;
 
     while (arg_processing < argc) {
@@ -93,6 +545,137 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
                 || strcmp(argv[arg_processing], "--station-kind") == 0)) {
             station_kind = argv[arg_processing + 1];
             arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-t") == 0
+                || strcmp(argv[arg_processing], "--transport") == 0)) {
+            transport = argv[arg_processing + 1];
+            arg_processing += 2;
+            if (transport != "default"
+                    && transport_profile_name(transport).empty()) {
+                std::cout << "Bad transport: " << transport << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::failure;
+                break;
+            }
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-c") == 0
+                || strcmp(argv[arg_processing], "--coalesce") == 0)) {
+            std::string mode = argv[arg_processing + 1];
+            arg_processing += 2;
+            if (mode == "none") {
+                coalesce_mode = CoalesceMode::none;
+            } else if (mode == "qos") {
+                coalesce_mode = CoalesceMode::qos;
+            } else if (mode == "table") {
+                coalesce_mode = CoalesceMode::table;
+            } else {
+                std::cout << "Bad coalesce mode: " << mode << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::failure;
+                break;
+            }
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-w") == 0
+                || strcmp(argv[arg_processing], "--summary-window") == 0)) {
+            summary_window_millisec = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-u") == 0
+                || strcmp(argv[arg_processing], "--use-summaries") == 0) {
+            use_summaries = true;
+            arg_processing += 1;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-r") == 0
+                || strcmp(argv[arg_processing], "--flow-rate") == 0)) {
+            flow_rate = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-f") == 0
+                || strcmp(argv[arg_processing], "--flow-burst") == 0)) {
+            flow_burst = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-b") == 0
+                || strcmp(argv[arg_processing], "--bulk-lots") == 0)) {
+            bulk_lots = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-x") == 0
+                || strcmp(argv[arg_processing], "--custom-filter") == 0) {
+            use_custom_filter = true;
+            arg_processing += 1;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-p") == 0
+                || strcmp(argv[arg_processing], "--statistics-period") == 0)) {
+            statistics_period_sec = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if (strcmp(argv[arg_processing], "-a") == 0
+                || strcmp(argv[arg_processing], "--all-temperatures") == 0) {
+            all_temperatures = true;
+            arg_processing += 1;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-m") == 0
+                || strcmp(argv[arg_processing], "--snapshot") == 0)) {
+            snapshot_file = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-g") == 0
+                || strcmp(argv[arg_processing], "--dashboard") == 0)) {
+            dashboard_refresh_millisec = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-l") == 0
+                || strcmp(argv[arg_processing], "--log-level") == 0)) {
+            std::string level = argv[arg_processing + 1];
+            arg_processing += 2;
+            if (!log_level_from_string(level, log_level)) {
+                std::cout << "Bad log level: " << level << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::failure;
+                break;
+            }
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-o") == 0
+                || strcmp(argv[arg_processing], "--recording") == 0)) {
+            recording_directory = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-z") == 0
+                || strcmp(argv[arg_processing], "--segment-size") == 0)) {
+            segment_size_mb = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-e") == 0
+                || strcmp(argv[arg_processing], "--speed") == 0)) {
+            replay_speed = atof(argv[arg_processing + 1]);
+            arg_processing += 2;
+            if (replay_speed < 0) {
+                std::cout << "Bad speed: " << argv[arg_processing - 1]
+                          << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::failure;
+                break;
+            }
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-n") == 0
+                || strcmp(argv[arg_processing], "--replicas") == 0)) {
+            replica_count = atoi(argv[arg_processing + 1]);
+            arg_processing += 2;
+            if (replica_count == 0) {
+                std::cout << "Bad replica count: " << argv[arg_processing - 1]
+                          << std::endl;
+                show_usage = true;
+                parse_result = ParseReturn::failure;
+                break;
+            }
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-y") == 0
+                || strcmp(argv[arg_processing], "--archive") == 0)) {
+            archive_directory = argv[arg_processing + 1];
+            arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-q") == 0
+                || strcmp(argv[arg_processing], "--query") == 0)) {
+            archive_query = argv[arg_processing + 1];
+            arg_processing += 2;
         } else if (strcmp(argv[arg_processing], "-h") == 0
                 || strcmp(argv[arg_processing], "--help") == 0) {
             std::cout << "Example application." << std::endl;
@@ -124,13 +707,133 @@ inline ApplicationArguments parse_arguments(int argc, char *argv[])
                     "                                   SUGAR_CONTROLLER,\n"\
                     "                                   MILK_CONTROLLER,\n"\
                     "                                   VANILLA_CONTROLLER\n"\
+                    "    -t, --transport    <string> Transports used to communicate.\n"\
+                    "                                Values:\n"\
+                    "                                   shmem (shared memory only),\n"\
+                    "                                   udp (UDPv4 loopback only),\n"\
+                    "                                   both (shared memory and UDPv4),\n"\
+                    "                                   default (builtin transports)\n"\
+                    "                                Default: default\n"\
+                    "    -c, --coalesce     <string> Keep only the newest temperature\n"\
+                    "                                reading per sensor when the\n"\
+                    "                                monitoring application falls behind.\n"\
+                    "                                Values:\n"\
+                    "                                   none (process every reading),\n"\
+                    "                                   qos (DataReader KEEP_LAST 1),\n"\
+                    "                                   table (latest-value table)\n"\
+                    "                                Default: none\n"\
+                    "    -w, --summary-window <int>  Milliseconds of temperature readings\n"\
+                    "                                summarized in each\n"\
+                    "                                TemperatureSummary. 0 disables\n"\
+                    "                                summaries.\n"\
+                    "                                Used only by tempering application.\n"\
+                    "                                Default: 1000\n"\
+                    "    -u, --use-summaries         Monitor temperature summaries instead\n"\
+                    "                                of every temperature reading.\n"\
+                    "                                Used only by monitoring application.\n"\
+                    "    -r, --flow-rate    <int>    Publish lot states asynchronously,\n"\
+                    "                                at most this many per second.\n"\
+                    "                                0 publishes synchronously.\n"\
+                    "                                Used only by monitoring application.\n"\
+                    "                                Default: 0\n"\
+                    "    -f, --flow-burst   <int>    Lot states sent in a burst before\n"\
+                    "                                the flow rate applies.\n"\
+                    "                                Used only by monitoring application.\n"\
+                    "                                Default: 100\n"\
+                    "    -b, --bulk-lots    <int>    Lots started at once when the\n"\
+                    "                                monitoring application starts.\n"\
+                    "                                Default: 0\n"\
+                    "    -x, --custom-filter         Use the compiled custom filters instead\n"\
+                    "                                of the builtin SQL filter:\n"\
+                    "                                TemperatureRangeFilter in the\n"\
+                    "                                monitoring application, and\n"\
+                    "                                LotStationIndexFilter in the\n"\
+                    "                                ingredient application.\n"\
+                    "    -p, --statistics-period <int> Seconds between content filter\n"\
+                    "                                and instance statistics. 0\n"\
+                    "                                disables them.\n"\
+                    "                                Used by ingredient and monitoring\n"\
+                    "                                applications.\n"\
+                    "                                Default: 0\n"\
+                    "    -a, --all-temperatures      Monitor every temperature reading, not\n"\
+                    "                                only those out of range, for the\n"\
+                    "                                per-sensor quantiles and anomaly\n"\
+                    "                                detection.\n"\
+                    "                                Used only by monitoring application.\n"\
+                    "    -m, --snapshot     <file>   Checkpoint the lot table to this\n"\
+                    "                                memory-mapped file, and restore it\n"\
+                    "                                at startup.\n"\
+                    "                                Used only by monitoring application.\n"\
+                    "    -g, --dashboard    <int>    Show a dashboard, redrawn every this\n"\
+                    "                                many milliseconds, instead of\n"\
+                    "                                printing each update. 0 prints each\n"\
+                    "                                update.\n"\
+                    "                                Used only by monitoring application.\n"\
+                    "                                Default: 0\n"\
+                    "    -l, --log-level    <string> Least important messages logged.\n"\
+                    "                                Values:\n"\
+                    "                                   error, warning, info, debug\n"\
+                    "                                Default: info\n"\
+                    "    -o, --recording    <dir>    Directory of the recording.\n"\
+                    "                                Used by recording and replay\n"\
+                    "                                applications.\n"\
+                    "                                Default: recording\n"\
+                    "    -z, --segment-size <int>    Megabytes of each segment file of\n"\
+                    "                                the recording, preallocated.\n"\
+                    "                                Used only by recording application.\n"\
+                    "                                Default: 64\n"\
+                    "    -e, --speed        <float>  Speed of the replay: 1 keeps the\n"\
+                    "                                original timing, 2 is twice as\n"\
+                    "                                fast, 0 as fast as possible.\n"\
+                    "                                Used only by replay application.\n"\
+                    "                                Default: 1\n"\
+                    "    -n, --replicas     <int>    Replay each sensor and lot this\n"\
+                    "                                many times, with other sensor_ids\n"\
+                    "                                and lot_ids, to multiply the load.\n"\
+                    "                                Used only by replay application.\n"\
+                    "                                Default: 1\n"\
+                    "    -y, --archive      <dir>    Directory of the temperature archive.\n"\
+                    "                                Used by archiver and archive query\n"\
+                    "                                applications.\n"\
+                    "                                Default: archive\n"\
+                    "    -q, --query        <string> Readings to find in the archive:\n"\
+                    "                                   \"sensor <id> <from> <to>\"\n"\
+                    "                                   \"above <degrees> [<from> <to>]\"\n"\
+                    "                                with the times in seconds since\n"\
+                    "                                1970.\n"\
+                    "                                Used only by archive query\n"\
+                    "                                application.\n"\
                     "    -v, --verbosity     <int>   How much debugging output to show.\n"\
                     "                                Range: 0-5 \n"
                     "                                Default: 0"
                 << std::endl;
     }
 
-    return { parse_result, domain_id, sample_count, sensor_id, verbosity, station_kind };
+    return { parse_result,
+             domain_id,
+             sample_count,
+             sensor_id,
+             verbosity,
+             station_kind,
+             transport,
+             coalesce_mode,
+             summary_window_millisec,
+             use_summaries,
+             flow_rate,
+             flow_burst,
+             bulk_lots,
+             use_custom_filter,
+             statistics_period_sec,
+             all_temperatures,
+             snapshot_file,
+             dashboard_refresh_millisec,
+             log_level,
+             recording_directory,
+             segment_size_mb,
+             replay_speed,
+             replica_count,
+             archive_directory,
+             archive_query };
 }
 
 }  // namespace application
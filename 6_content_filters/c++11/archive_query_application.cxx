@@ -0,0 +1,126 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "application.hpp"  // Argument parsing
+#include "benchmark.hpp"  // Stopwatch
+#include "temperature_archive.hpp"  // Columnar archive files
+
+using namespace application;
+
+// Archive query application:
+// Finds readings in the archive of the archiver application, without DDS:
+// - "sensor <id> <from> <to>": the readings of a sensor in a time range
+// - "above <degrees> [<from> <to>]": the readings above some degrees, in a
+//   time range or in the whole archive
+// The times are in seconds since 1970, and may have decimals.
+//
+// Only the blocks whose time and degree ranges, and sensor_ids, can match
+// are decoded. They are scanned in parallel, by one thread per core.
+//
+// -y, --archive sets the directory of the archive, -q, --query the query,
+// and -s, --sample-count the most readings printed.
+
+void print_reading(const temperature_archive::Reading& reading)
+{
+    // The timestamp in seconds, to the microsecond
+    int64_t seconds = reading.timestamp_us / 1000000;
+    int64_t microseconds = reading.timestamp_us % 1000000;
+    if (microseconds < 0) {
+        seconds--;
+        microseconds += 1000000;
+    }
+    char timestamp[32];
+    std::snprintf(
+            timestamp,
+            sizeof(timestamp),
+            "%lld.%06lld",
+            static_cast<long long>(seconds),
+            static_cast<long long>(microseconds));
+    std::cout << timestamp << " [sensor_id: ";
+    std::cout.write(reading.sensor_id, reading.sensor_id_length);
+    std::cout << ", degrees: " << reading.degrees << "]\n";
+}
+
+void run_example(const ApplicationArguments& arguments)
+{
+    temperature_archive::Query query;
+    if (!temperature_archive::parse_query(arguments.archive_query, query)) {
+        throw std::runtime_error(
+                "Bad query: \"" + arguments.archive_query
+                + "\", see -q, --query in the help");
+    }
+
+    temperature_archive::Archive archive(arguments.archive_directory);
+    std::cout << "Archive " << arguments.archive_directory << ": "
+              << archive.file_count() << " files, " << archive.block_count()
+              << " blocks" << std::endl;
+    if (archive.incomplete_files() > 0) {
+        std::cout << "    " << archive.incomplete_files()
+                  << " files end with an incomplete block, which is not"
+                  << " queried" << std::endl;
+    }
+
+    unsigned int thread_count = std::thread::hardware_concurrency();
+    temperature_archive::QueryStatistics statistics;
+    benchmark::Stopwatch stopwatch;
+    std::vector<temperature_archive::Reading> readings =
+            archive.query(query, thread_count, statistics);
+    double query_seconds = stopwatch.elapsed_seconds();
+
+    size_t printed = 0;
+    for (const temperature_archive::Reading& reading : readings) {
+        if (printed == arguments.sample_count) {
+            std::cout << "... " << readings.size() - printed << " more"
+                      << std::endl;
+            break;
+        }
+        print_reading(reading);
+        printed++;
+    }
+    std::cout << readings.size() << " readings found in "
+              << query_seconds * 1000 << " ms: " << statistics.blocks_scanned
+              << " of " << statistics.blocks << " blocks decoded ("
+              << statistics.readings_scanned << " readings) by "
+              << std::max(1u, thread_count) << " threads" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments);
+    } catch (const std::exception& ex) {
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
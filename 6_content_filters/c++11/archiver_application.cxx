@@ -0,0 +1,170 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <chrono>
+#include <iostream>
+
+#include <dds/sub/ddssub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "statistics_period.hpp"  // Periodic tasks
+#include "temperature_archive.hpp"  // Columnar archive files
+
+using namespace application;
+
+// Archiver application:
+// Keeps the history of the ChocolateTemperature Topic in a columnar archive,
+// which takes a few bytes per reading instead of a record per sample. See
+// temperature_archive.hpp for the format, and archive_query_application.cxx
+// to find readings in it.
+//
+// The readings are archived with their source timestamp. A block is written
+// when it is full, or when its first reading is older than
+// ARCHIVE_FLUSH_PERIOD, so that little history is lost if the application
+// stops.
+//
+// -y, --archive sets the directory of the archive, -s, --sample-count the
+// number of readings archived before stopping, and -p, --statistics-period
+// how often the archive statistics are printed.
+
+const std::chrono::seconds ARCHIVE_FLUSH_PERIOD(60);
+
+int64_t time_microsec(const dds::core::Time& time)
+{
+    return time.sec() * 1000000LL + time.nanosec() / 1000;
+}
+
+void print_archive_statistics(
+        const temperature_archive::ArchiveWriter& archive,
+        const dds::sub::DataReader<Temperature>& reader)
+{
+    std::cout << "Archive " << archive.file_path() << ": "
+              << archive.readings() << " readings, " << archive.blocks()
+              << " blocks, " << archive.bytes() << " bytes";
+    uint64_t written = archive.readings() - archive.pending();
+    if (written > 0) {
+        std::cout << " (" << static_cast<double>(archive.bytes()) / written
+                  << " bytes per reading)";
+    }
+    std::cout << ", " << reader.sample_lost_status().total_count()
+              << " lost, " << reader.sample_rejected_status().total_count()
+              << " rejected" << std::endl;
+}
+
+void run_example(const ApplicationArguments& arguments)
+{
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+
+    temperature_archive::ArchiveWriter archive(arguments.archive_directory);
+
+    // A DomainParticipant allows an application to begin communicating in
+    // a DDS domain. Typically there is one DomainParticipant per application.
+    // Load DomainParticipant QoS profile
+    dds::domain::DomainParticipant participant(
+            arguments.domain_id,
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::ArchiverApplication",
+                    arguments.transport));
+
+    dds::topic::Topic<Temperature> temperature_topic(
+            participant,
+            CHOCOLATE_TEMPERATURE_TOPIC);
+
+    // Every reading is archived: the DataReader keeps all the samples not
+    // taken yet, as that of the recording application does
+    dds::sub::Subscriber subscriber(participant);
+    dds::sub::DataReader<Temperature> temperature_reader(
+            subscriber,
+            temperature_topic,
+            qos_provider.datareader_qos(
+                    "ChocolateFactoryLibrary::"
+                    "ChocolateTemperatureRecorderProfile"));
+
+    unsigned int samples_archived = 0;
+    auto block_start = std::chrono::steady_clock::now();
+    dds::sub::cond::ReadCondition temperature_condition(
+            temperature_reader,
+            dds::sub::status::DataState::any(),
+            [&]() {
+                dds::sub::LoanedSamples<Temperature> samples =
+                        temperature_reader.take();
+                for (const auto& sample : samples) {
+                    if (!sample.info().valid()) {
+                        continue;
+                    }
+                    if (archive.pending() == 0) {
+                        block_start = std::chrono::steady_clock::now();
+                    }
+                    archive.add(
+                            time_microsec(sample.info().source_timestamp()),
+                            sample.data().sensor_id,
+                            sample.data().degrees);
+                    samples_archived++;
+                }
+            });
+
+    dds::core::cond::WaitSet waitset;
+    waitset += temperature_condition;
+
+    std::cout << "Archiving to " << archive.file_path() << std::endl;
+    StatisticsPeriod statistics_period(arguments.statistics_period_sec);
+    while (!shutdown_requested && samples_archived < arguments.sample_count) {
+        // Dispatch will call the handlers associated to the WaitSet conditions
+        // when they activate. Wait up to 10s each time.
+        waitset.dispatch(statistics_period.wait_time(dds::core::Duration(10)));
+        if (archive.pending() > 0
+            && std::chrono::steady_clock::now() - block_start
+                    >= ARCHIVE_FLUSH_PERIOD) {
+            archive.flush();
+        }
+        if (statistics_period.due()) {
+            print_archive_statistics(archive, temperature_reader);
+        }
+    }
+
+    archive.flush();
+    print_archive_statistics(archive, temperature_reader);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
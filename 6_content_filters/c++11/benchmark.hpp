@@ -0,0 +1,64 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Helpers shared by the benchmark applications
+namespace benchmark {
+
+// Measures the wall-clock time elapsed since it was created or restarted
+class Stopwatch {
+public:
+    Stopwatch() : start_time(std::chrono::steady_clock::now())
+    {
+    }
+
+    void restart()
+    {
+        start_time = std::chrono::steady_clock::now();
+    }
+
+    double elapsed_seconds() const
+    {
+        return std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                .count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_time;
+};
+
+// Prints one line of results: total operations, rate and cost per operation
+inline void print_result(
+        const std::string& name,
+        unsigned long long operations,
+        double seconds)
+{
+    double rate = seconds > 0 ? operations / seconds : 0;
+    double ns_per_op = operations > 0 ? seconds * 1e9 / operations : 0;
+    std::cout << std::left << std::setw(44) << name << std::right
+              << std::setw(10) << operations << " ops " << std::fixed
+              << std::setprecision(0) << std::setw(12) << rate << " ops/s "
+              << std::setprecision(1) << std::setw(10) << ns_per_op
+              << " ns/op" << std::endl;
+}
+
+}  // namespace benchmark
+
+#endif  // BENCHMARK_HPP
@@ -0,0 +1,187 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <iostream>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "benchmark.hpp"  // Stopwatch and result printing
+
+using namespace application;
+
+// Catch-up benchmark:
+// A DataWriter publishes the state of 1000, 10000 and 100000 lots. Then a
+// late-joining DataReader is created in a new DomainParticipant, and the time
+// until it has received the state of every lot is measured, with:
+// 1) The builtin Pattern.Status profile
+// 2) The ChocolateLotStateProfile and ChocolateLotStateMonitorProfile, tuned
+//    for catching up
+//
+// -s, --sample-count sets the largest number of lots.
+
+const unsigned int DEFAULT_SAMPLE_COUNT = 100000;
+
+// Stop waiting for the state of the lots after this time
+const double CATCH_UP_TIMEOUT_SEC = 120;
+
+void benchmark_catch_up(
+        unsigned int lot_count,
+        bool tuned,
+        dds::core::QosProvider& qos_provider,
+        const dds::domain::qos::DomainParticipantQos& participant_qos,
+        dds::domain::DomainParticipant& writer_participant)
+{
+    const std::string writer_profile = tuned
+            ? "ChocolateFactoryLibrary::ChocolateLotStateProfile"
+            : "BuiltinQosLib::Pattern.Status";
+    const std::string reader_profile = tuned
+            ? "ChocolateFactoryLibrary::ChocolateLotStateMonitorProfile"
+            : "BuiltinQosLib::Pattern.Status";
+
+    // Each test uses its own Topic, so its DataReader does not receive the
+    // lots of the other tests
+    std::string topic_name = std::string("CatchUpBenchmark")
+            + (tuned ? "Tuned" : "Builtin") + std::to_string(lot_count);
+    dds::topic::Topic<ChocolateLotState> writer_topic(
+            writer_participant,
+            topic_name);
+    dds::pub::DataWriter<ChocolateLotState> writer(
+            dds::pub::Publisher(writer_participant),
+            writer_topic,
+            qos_provider.datawriter_qos(writer_profile));
+
+    // The current state of every lot, kept by the DataWriter for late joiners
+    ChocolateLotState sample;
+    sample.lot_status = LotStatusKind::WAITING;
+    sample.next_station = StationKind::COCOA_BUTTER_CONTROLLER;
+    for (unsigned int i = 0; i < lot_count && !shutdown_requested; i++) {
+        sample.lot_id = i;
+        writer.write(sample);
+    }
+
+    // The late joiner, including its discovery
+    benchmark::Stopwatch stopwatch;
+    dds::domain::DomainParticipant reader_participant(
+            writer_participant.domain_id(),
+            participant_qos);
+    dds::topic::Topic<ChocolateLotState> reader_topic(
+            reader_participant,
+            topic_name);
+    dds::sub::DataReader<ChocolateLotState> reader(
+            dds::sub::Subscriber(reader_participant),
+            reader_topic,
+            qos_provider.datareader_qos(reader_profile));
+
+    unsigned int received = 0;
+    unsigned int take_count = 0;
+    while (!shutdown_requested && received < lot_count
+           && stopwatch.elapsed_seconds() < CATCH_UP_TIMEOUT_SEC) {
+        dds::sub::LoanedSamples<ChocolateLotState> samples = reader.take();
+        if (samples.length() == 0) {
+            rti::util::sleep(dds::core::Duration::from_millisecs(1));
+            continue;
+        }
+        take_count++;
+        for (const auto& sample : samples) {
+            if (sample.info().valid()) {
+                received++;
+            }
+        }
+    }
+
+    benchmark::print_result(
+            std::string(tuned ? "Tuned profiles" : "Pattern.Status") + ", "
+                    + std::to_string(lot_count) + " lots",
+            received,
+            stopwatch.elapsed_seconds());
+    std::cout << "    take() calls: " << take_count << ", samples per call: "
+              << (take_count > 0 ? received / take_count : 0) << std::endl;
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        const std::string& transport)
+{
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+
+    dds::domain::qos::DomainParticipantQos participant_qos =
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::BenchmarkProfile",
+                    transport);
+    dds::domain::DomainParticipant writer_participant(
+            domain_id,
+            participant_qos);
+
+    std::cout << "Benchmarking the time for a late joiner to receive the "
+                 "state of every lot"
+              << std::endl;
+
+    for (uint64_t count = 1000; count <= sample_count; count *= 10) {
+        unsigned int lot_count = static_cast<unsigned int>(count);
+        benchmark_catch_up(
+                lot_count,
+                false,
+                qos_provider,
+                participant_qos,
+                writer_participant);
+        benchmark_catch_up(
+                lot_count,
+                true,
+                qos_provider,
+                participant_qos,
+                writer_participant);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    // The sample count defaults to infinite, use a finite number of lots
+    unsigned int sample_count = arguments.sample_count
+                    == (std::numeric_limits<unsigned int>::max)()
+            ? DEFAULT_SAMPLE_COUNT
+            : arguments.sample_count;
+
+    try {
+        run_example(arguments.domain_id, sample_count, arguments.transport);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
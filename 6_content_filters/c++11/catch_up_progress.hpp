@@ -0,0 +1,143 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef CATCH_UP_PROGRESS_HPP
+#define CATCH_UP_PROGRESS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+// Tracks the initial burst of samples that a late-joining DataReader of state
+// data receives: the current state of every instance. While catching up, the
+// application should not print each sample; this prints the progress once
+// per report period instead.
+//
+// Catching up ends when the application reports that the history has been
+// received, for example with DataReader::wait_for_historical_data(). Live
+// samples may keep arriving meanwhile. As a fallback, it also ends when no
+// sample has arrived within timeout.
+class CatchUpProgress {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    explicit CatchUpProgress(
+            clock::duration timeout,
+            clock::duration report_period = std::chrono::seconds(1))
+            : timeout(timeout),
+              report_period(report_period),
+              start_time(clock::now()),
+              last_sample_time(start_time),
+              next_report_time(start_time + report_period),
+              received_count(0),
+              expected_count(0),
+              history_received(false),
+              catching_up(true)
+    {
+    }
+
+    // Sets how many samples are expected, for the percentage and ETA. For
+    // example, the number of lots in a snapshot.
+    void expect(uint64_t count)
+    {
+        expected_count = count;
+    }
+
+    bool active() const
+    {
+        return catching_up;
+    }
+
+    void received(uint64_t count, clock::time_point now)
+    {
+        if (catching_up && count > 0) {
+            received_count += count;
+            last_sample_time = now;
+        }
+    }
+
+    // Reports that the history has been received: catching up ends with the
+    // next update()
+    void history_complete()
+    {
+        history_received = true;
+    }
+
+    // Prints the progress to out when a report period has elapsed. Returns
+    // true when catching up has just ended.
+    bool update(clock::time_point now, std::ostream& out = std::cout)
+    {
+        if (!catching_up) {
+            return false;
+        }
+        bool timed_out = now - last_sample_time >= timeout;
+        if (history_received || timed_out) {
+            catching_up = false;
+            out << "Caught up: " << received_count << " samples in "
+                << seconds(now - start_time) << " s"
+                << (history_received ? "" : " (no history received)")
+                << std::endl;
+            return true;
+        }
+        if (now >= next_report_time) {
+            next_report_time = now + report_period;
+            print_progress(now, out);
+        }
+        return false;
+    }
+
+    uint64_t received() const
+    {
+        return received_count;
+    }
+
+    // Whether catching up ended with the history, not with the timeout
+    bool received_history() const
+    {
+        return history_received;
+    }
+
+private:
+    static double seconds(clock::duration duration)
+    {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    void print_progress(clock::time_point now, std::ostream& out) const
+    {
+        double elapsed_sec = seconds(now - start_time);
+        double rate = elapsed_sec > 0 ? received_count / elapsed_sec : 0;
+        out << "Catching up: " << received_count << " samples";
+        if (expected_count > 0 && received_count < expected_count) {
+            out << " of " << expected_count << " ("
+                << 100 * received_count / expected_count << "%)";
+        }
+        out << ", " << static_cast<uint64_t>(rate) << " per second";
+        if (expected_count > received_count && rate > 0) {
+            out << ", ETA " << (expected_count - received_count) / rate
+                << " s";
+        }
+        out << std::endl;
+    }
+
+    clock::duration timeout;
+    clock::duration report_period;
+    clock::time_point start_time;
+    clock::time_point last_sample_time;
+    clock::time_point next_report_time;
+    uint64_t received_count;
+    uint64_t expected_count;
+    bool history_received;
+    bool catching_up;
+};
+
+#endif  // CATCH_UP_PROGRESS_HPP
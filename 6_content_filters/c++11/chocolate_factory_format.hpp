@@ -0,0 +1,292 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef CHOCOLATE_FACTORY_FORMAT_HPP
+#define CHOCOLATE_FACTORY_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "chocolate_factory.hpp"
+
+// Allocation-free formatters for the samples, used on the data paths
+
+// Name of an enumerator, padded so that it is copied with a fixed size
+const size_t NAME_CAPACITY = 24;
+
+struct Name {
+    char text[NAME_CAPACITY];
+    size_t length;
+};
+
+#define CHOCOLATE_FACTORY_NAME(text) \
+    {                                \
+        text, sizeof(text) - 1       \
+    }
+
+// Names in the order of chocolate_factory.idl, then that of unknown values
+inline const Name& station_kind_text(StationKind station)
+{
+    static constexpr Name NAMES[] = {
+        CHOCOLATE_FACTORY_NAME("INVALID_CONTROLLER"),
+        CHOCOLATE_FACTORY_NAME("COCOA_BUTTER_CONTROLLER"),
+        CHOCOLATE_FACTORY_NAME("SUGAR_CONTROLLER"),
+        CHOCOLATE_FACTORY_NAME("MILK_CONTROLLER"),
+        CHOCOLATE_FACTORY_NAME("VANILLA_CONTROLLER"),
+        CHOCOLATE_FACTORY_NAME("TEMPERING_CONTROLLER"),
+        CHOCOLATE_FACTORY_NAME("")
+    };
+    size_t index = static_cast<size_t>(station);
+    size_t unknown = sizeof(NAMES) / sizeof(NAMES[0]) - 1;
+    return NAMES[index < unknown ? index : unknown];
+}
+
+inline const Name& lot_status_kind_text(LotStatusKind lot_status)
+{
+    static constexpr Name NAMES[] = { CHOCOLATE_FACTORY_NAME("WAITING"),
+                                      CHOCOLATE_FACTORY_NAME("PROCESSING"),
+                                      CHOCOLATE_FACTORY_NAME("COMPLETED"),
+                                      CHOCOLATE_FACTORY_NAME("") };
+    size_t index = static_cast<size_t>(lot_status);
+    size_t unknown = sizeof(NAMES) / sizeof(NAMES[0]) - 1;
+    return NAMES[index < unknown ? index : unknown];
+}
+
+#undef CHOCOLATE_FACTORY_NAME
+
+inline const char *station_kind_name(StationKind station)
+{
+    return station_kind_text(station).text;
+}
+
+inline const char *lot_status_kind_name(LotStatusKind lot_status)
+{
+    return lot_status_kind_text(lot_status).text;
+}
+
+// Appends text to a caller's buffer, truncated and null-terminated
+class TextBuffer {
+public:
+    TextBuffer(char *data, size_t capacity)
+            : data(data), capacity(capacity), length(0)
+    {
+        if (capacity > 0) {
+            data[0] = '\0';
+        }
+    }
+
+    TextBuffer& append(const char *text, size_t text_length)
+    {
+        if (length + 1 >= capacity) {
+            return *this;
+        }
+        size_t available = capacity - length - 1;
+        size_t count = text_length < available ? text_length : available;
+        std::memcpy(data + length, text, count);
+        length += count;
+        data[length] = '\0';
+        return *this;
+    }
+
+    // Copies the whole padded name when there is room for it
+    TextBuffer& append(const Name& name)
+    {
+        if (capacity - length <= sizeof(name.text)) {
+            return append(name.text, name.length);
+        }
+        std::memcpy(data + length, name.text, sizeof(name.text));
+        length += name.length;
+        data[length] = '\0';
+        return *this;
+    }
+
+    // String literals
+    template <size_t N>
+    TextBuffer& append(const char (&text)[N])
+    {
+        if (capacity - length <= N) {
+            return append(text, N - 1);
+        }
+        std::memcpy(data + length, text, N);
+        length += N - 1;
+        return *this;
+    }
+
+    TextBuffer& append(const std::string& text)
+    {
+        return append(text.data(), text.size());
+    }
+
+    // Integers are written digit by digit, from the last one
+    TextBuffer& append(uint64_t value)
+    {
+        char digits[20];
+        size_t first = sizeof(digits);
+        do {
+            digits[--first] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        return append(digits + first, sizeof(digits) - first);
+    }
+
+    TextBuffer& append(int64_t value)
+    {
+        if (value >= 0) {
+            return append(static_cast<uint64_t>(value));
+        }
+        append("-");
+        // Negated as unsigned, which is defined for the lowest value too
+        return append(0 - static_cast<uint64_t>(value));
+    }
+
+    const char *c_str() const
+    {
+        return data;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    char *data;
+    size_t capacity;
+    size_t length;
+};
+
+// Fits any ChocolateLotState, and a Temperature with a 64-character sensor_id
+const size_t SAMPLE_TEXT_SIZE = 128;
+
+// Writes "[lot_id: 1, station: ..., ...]" and returns its length
+inline size_t format_sample(
+        const ChocolateLotState& state,
+        char *buffer,
+        size_t size)
+{
+    TextBuffer text(buffer, size);
+    text.append("[lot_id: ")
+            .append(static_cast<uint64_t>(state.lot_id))
+            .append(", station: ")
+            .append(station_kind_text(state.station))
+            .append(", next_station: ")
+            .append(station_kind_text(state.next_station))
+            .append(", lot_status: ")
+            .append(lot_status_kind_text(state.lot_status))
+            .append("]");
+    return text.size();
+}
+
+// A sensor_id copied into fixed-size bytes, truncated if longer
+const size_t SENSOR_ID_CAPACITY = 64;
+
+struct SensorId {
+    explicit SensorId(const std::string& sensor_id)
+            : length(static_cast<uint8_t>(
+                    sensor_id.size() < SENSOR_ID_CAPACITY
+                            ? sensor_id.size()
+                            : SENSOR_ID_CAPACITY))
+    {
+        std::memcpy(text, sensor_id.data(), length);
+    }
+
+    char text[SENSOR_ID_CAPACITY];
+    uint8_t length;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const SensorId& sensor_id)
+{
+    return out.write(sensor_id.text, sensor_id.length);
+}
+
+// Writes "[sensor_id: ..., degrees: 32]" and returns its length
+inline size_t format_temperature(
+        const char *sensor_id,
+        size_t sensor_id_length,
+        int32_t degrees,
+        char *buffer,
+        size_t size)
+{
+    TextBuffer text(buffer, size);
+    text.append("[sensor_id: ")
+            .append(sensor_id, sensor_id_length)
+            .append(", degrees: ")
+            .append(static_cast<int64_t>(degrees))
+            .append("]");
+    return text.size();
+}
+
+inline size_t format_sample(
+        const Temperature& temperature,
+        char *buffer,
+        size_t size)
+{
+    return format_temperature(
+            temperature.sensor_id.data(),
+            temperature.sensor_id.size(),
+            temperature.degrees,
+            buffer,
+            size);
+}
+
+// A copy of a sample, formatted by the writer thread of the log
+template <typename T>
+struct FormattedSample {
+    T sample;
+};
+
+// A Temperature copies its sensor_id into a SensorId, not a std::string
+template <>
+struct FormattedSample<Temperature> {
+    FormattedSample(const Temperature& temperature)
+            : sensor_id(temperature.sensor_id), degrees(temperature.degrees)
+    {
+    }
+
+    SensorId sensor_id;
+    int32_t degrees;
+};
+
+template <typename T>
+FormattedSample<typename std::decay<T>::type> formatted(T&& sample)
+{
+    return { std::forward<T>(sample) };
+}
+
+template <typename T>
+std::ostream& operator<<(std::ostream& out, const FormattedSample<T>& formatted)
+{
+    char buffer[SAMPLE_TEXT_SIZE];
+    size_t length = format_sample(formatted.sample, buffer, sizeof(buffer));
+    return out.write(buffer, static_cast<std::streamsize>(length));
+}
+
+inline std::ostream& operator<<(
+        std::ostream& out,
+        const FormattedSample<Temperature>& formatted)
+{
+    char buffer[SAMPLE_TEXT_SIZE];
+    size_t length = format_temperature(
+            formatted.sensor_id.text,
+            formatted.sensor_id.length,
+            formatted.degrees,
+            buffer,
+            sizeof(buffer));
+    return out.write(buffer, static_cast<std::streamsize>(length));
+}
+
+#endif  // CHOCOLATE_FACTORY_FORMAT_HPP
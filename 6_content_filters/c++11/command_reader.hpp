@@ -0,0 +1,181 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef COMMAND_READER_HPP
+#define COMMAND_READER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+#include "application.hpp"  // shutdown_requested
+
+// Commands passed from the thread that parses them to the thread that runs
+// them
+template <typename Command>
+class CommandQueue {
+public:
+    void push(Command command)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.push_back(std::move(command));
+    }
+
+    std::vector<Command> take_all()
+    {
+        std::vector<Command> taken;
+        std::lock_guard<std::mutex> lock(mutex);
+        taken.swap(commands);
+        return taken;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<Command> commands;
+};
+
+// Reads the lines of the standard input in a thread, and passes each one to
+// a handler in that thread. The thread waits for input at most POLL_PERIOD
+// at a time, so it stops soon after shutdown is requested or the
+// CommandReader is destroyed, which joins it.
+//
+// On Windows, the wait only applies to a console: with redirected input, or
+// once a line is partly typed, the thread blocks until the line ends.
+class CommandReader {
+public:
+    typedef std::function<void(const std::string&)> LineHandler;
+
+    explicit CommandReader(LineHandler handler)
+            : handler(std::move(handler)),
+              stopping(false),
+              thread(&CommandReader::read_lines, this)
+    {
+    }
+
+    ~CommandReader()
+    {
+        stop();
+    }
+
+    CommandReader(const CommandReader&) = delete;
+    CommandReader& operator=(const CommandReader&) = delete;
+
+    void stop()
+    {
+        stopping = true;
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+private:
+    static constexpr int POLL_PERIOD_MILLISEC = 100;
+
+    enum class Input { ready, none, end };
+
+    static Input wait_for_input()
+    {
+#ifdef _WIN32
+        switch (WaitForSingleObject(
+                GetStdHandle(STD_INPUT_HANDLE),
+                POLL_PERIOD_MILLISEC)) {
+        case WAIT_OBJECT_0:
+            return Input::ready;
+        case WAIT_TIMEOUT:
+            return Input::none;
+        default:
+            return Input::end;
+        }
+#else
+        pollfd input = { STDIN_FILENO, POLLIN, 0 };
+        int result = poll(&input, 1, POLL_PERIOD_MILLISEC);
+        if (result < 0) {
+            return errno == EINTR ? Input::none : Input::end;
+        }
+        return result == 0 ? Input::none : Input::ready;
+#endif
+    }
+
+    // Reads the available input, at most one buffer. Returns 0 at the end of
+    // the input.
+    static long read_input(char *buffer, size_t size)
+    {
+#ifdef _WIN32
+        DWORD count = 0;
+        if (!ReadFile(
+                    GetStdHandle(STD_INPUT_HANDLE),
+                    buffer,
+                    static_cast<DWORD>(size),
+                    &count,
+                    NULL)) {
+            return 0;
+        }
+        return static_cast<long>(count);
+#else
+        ssize_t count;
+        do {
+            count = read(STDIN_FILENO, buffer, size);
+        } while (count < 0 && errno == EINTR);
+        return count < 0 ? 0 : static_cast<long>(count);
+#endif
+    }
+
+    void read_lines()
+    {
+        std::string line;
+        char buffer[256];
+        while (!stopping && !application::shutdown_requested) {
+            Input input = wait_for_input();
+            if (input == Input::none) {
+                continue;
+            }
+            long count = input == Input::ready
+                    ? read_input(buffer, sizeof(buffer))
+                    : 0;
+            if (count == 0) {
+                // The end of the input ends the last line
+                if (!line.empty()) {
+                    handler(line);
+                }
+                return;
+            }
+            for (long i = 0; i < count; i++) {
+                if (buffer[i] == '\n') {
+                    handler(line);
+                    line.clear();
+                } else if (buffer[i] != '\r') {
+                    line += buffer[i];
+                }
+            }
+        }
+    }
+
+    LineHandler handler;
+    std::atomic<bool> stopping;
+    // Last, so that it starts once the other members are initialized
+    std::thread thread;
+};
+
+#endif  // COMMAND_READER_HPP
@@ -0,0 +1,200 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <iostream>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "benchmark.hpp"  // Stopwatch and result printing
+#include "temperature_range_filter.hpp"  // Compiled temperature filter
+
+using namespace application;
+
+// Content filter benchmark:
+// Compares the builtin SQL filter with the compiled TemperatureRangeFilter,
+// filtering the temperature range used by the monitoring application.
+// The filters are registered in the DomainParticipants of both the DataWriter
+// and the DataReader, so the DataWriter filters: the time to write the
+// samples includes evaluating the filter for each of them.
+//
+// -s, --sample-count sets how many samples are written per filter.
+
+const unsigned int DEFAULT_SAMPLE_COUNT = 1000000;
+
+// One in OUT_OF_RANGE_PERIOD samples is out of range and passes the filter
+const unsigned int OUT_OF_RANGE_PERIOD = 100;
+
+// Stop waiting for samples that have not been received after this time
+const double RECEIVE_TIMEOUT_SEC = 60;
+
+void benchmark_filter(
+        const std::string& label,
+        bool use_custom_filter,
+        dds::core::QosProvider& qos_provider,
+        dds::domain::DomainParticipant& writer_participant,
+        dds::domain::DomainParticipant& reader_participant,
+        unsigned int sample_count)
+{
+    // Each filter uses its own Topic, so the DataReaders do not match the
+    // DataWriter of the other benchmark
+    std::string topic_name = use_custom_filter ? "FilterBenchmarkCustom"
+                                               : "FilterBenchmarkSql";
+    dds::topic::Topic<Temperature> writer_topic(writer_participant, topic_name);
+    dds::topic::Topic<Temperature> reader_topic(reader_participant, topic_name);
+    dds::topic::ContentFilteredTopic<Temperature> filtered_topic(
+            reader_topic,
+            topic_name + "Filtered",
+            temperature_range_filter("32", "30", use_custom_filter));
+
+    dds::pub::DataWriter<Temperature> writer(
+            dds::pub::Publisher(writer_participant),
+            writer_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::BenchmarkProfile"));
+    dds::sub::DataReader<Temperature> reader(
+            dds::sub::Subscriber(reader_participant),
+            filtered_topic,
+            qos_provider.datareader_qos(
+                    "ChocolateFactoryLibrary::BenchmarkProfile"));
+
+    // Wait for the DataWriter to discover the DataReader and its filter
+    while (!shutdown_requested
+           && writer.publication_matched_status().current_count() == 0) {
+        rti::util::sleep(dds::core::Duration::from_millisecs(100));
+    }
+
+    Temperature sample;
+    sample.sensor_id = "filter_benchmark";
+    unsigned long long expected = 0;
+    unsigned long long received = 0;
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int i = 0; i < sample_count && !shutdown_requested; i++) {
+        if (i % OUT_OF_RANGE_PERIOD == 0) {
+            sample.degrees = 33;
+            expected++;
+        } else {
+            sample.degrees = 30 + i % 3;
+        }
+        writer.write(sample);
+
+        // Drain the DataReader while writing, so its queue stays small
+        if (i % 1000 == 0) {
+            dds::sub::LoanedSamples<Temperature> samples = reader.take();
+            received += samples.length();
+        }
+    }
+    double write_seconds = stopwatch.elapsed_seconds();
+
+    while (!shutdown_requested && received < expected
+           && stopwatch.elapsed_seconds() < RECEIVE_TIMEOUT_SEC) {
+        dds::sub::LoanedSamples<Temperature> samples = reader.take();
+        if (samples.length() == 0) {
+            rti::util::sleep(dds::core::Duration::from_millisecs(1));
+        }
+        received += samples.length();
+    }
+
+    benchmark::print_result(
+            label + " write and filter",
+            sample_count,
+            write_seconds);
+    benchmark::print_result(
+            label + " samples passed",
+            received,
+            stopwatch.elapsed_seconds());
+    if (received != expected) {
+        std::cout << "Expected " << expected << " samples to pass, received "
+                  << received << std::endl;
+    }
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        const std::string& transport)
+{
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+
+    dds::domain::qos::DomainParticipantQos participant_qos =
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::BenchmarkProfile",
+                    transport);
+    dds::domain::DomainParticipant writer_participant(
+            domain_id,
+            participant_qos);
+    dds::domain::DomainParticipant reader_participant(
+            domain_id,
+            participant_qos);
+    register_temperature_range_filter(writer_participant);
+    register_temperature_range_filter(reader_participant);
+
+    std::cout << "Benchmarking " << sample_count << " samples per filter, 1 in "
+              << OUT_OF_RANGE_PERIOD << " out of range" << std::endl;
+
+    benchmark_filter(
+            "Builtin SQL filter",
+            false,
+            qos_provider,
+            writer_participant,
+            reader_participant,
+            sample_count);
+    benchmark_filter(
+            "TemperatureRangeFilter",
+            true,
+            qos_provider,
+            writer_participant,
+            reader_participant,
+            sample_count);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    // The sample count defaults to infinite, use a finite number of samples
+    unsigned int sample_count = arguments.sample_count
+                    == (std::numeric_limits<unsigned int>::max)()
+            ? DEFAULT_SAMPLE_COUNT
+            : arguments.sample_count;
+
+    try {
+        run_example(arguments.domain_id, sample_count, arguments.transport);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
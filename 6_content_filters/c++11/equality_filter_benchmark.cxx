@@ -0,0 +1,192 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "benchmark.hpp"  // Stopwatch and result printing
+#include "equality_index_filter.hpp"  // Indexed sensor_id filter
+
+using namespace application;
+
+// Equality filter benchmark:
+// One DataWriter publishes temperatures to 10, 100 and 1000 DataReaders, each
+// filtering on its own sensor with "sensor_id = %0". The DataWriter filters
+// for all of them, so writing a sample evaluates their filters:
+// 1) With the builtin SQL filter, once per DataReader
+// 2) With the EqualityIndexFilter, with one lookup in its index
+//
+// -s, --sample-count sets how many samples are written per test.
+
+const unsigned int DEFAULT_SAMPLE_COUNT = 100000;
+
+// Stop waiting for the DataReaders to match after this time
+const double MATCH_TIMEOUT_SEC = 60;
+
+void benchmark_fan_out(
+        unsigned int reader_count,
+        bool use_custom_filter,
+        dds::core::QosProvider& qos_provider,
+        dds::domain::DomainParticipant& writer_participant,
+        dds::domain::DomainParticipant& reader_participant,
+        unsigned int sample_count)
+{
+    const std::string profile =
+            "ChocolateFactoryLibrary::FanOutBenchmarkProfile";
+
+    // Each test uses its own Topic, so its DataWriter does not match the
+    // DataReaders of the other tests
+    std::string topic_name = std::string("EqualityFilterBenchmark")
+            + (use_custom_filter ? "Index" : "Sql")
+            + std::to_string(reader_count);
+    dds::topic::Topic<Temperature> writer_topic(writer_participant, topic_name);
+    dds::topic::Topic<Temperature> reader_topic(reader_participant, topic_name);
+
+    // One DataReader per sensor
+    std::vector<Temperature> samples(reader_count);
+    std::vector<dds::sub::DataReader<Temperature>> readers;
+    dds::sub::Subscriber subscriber(reader_participant);
+    for (unsigned int i = 0; i < reader_count; i++) {
+        samples[i].sensor_id = "sensor_" + std::to_string(i);
+        samples[i].degrees = 31;
+        dds::topic::ContentFilteredTopic<Temperature> filtered_topic(
+                reader_topic,
+                topic_name + "Filtered" + std::to_string(i),
+                equality_filter<Temperature>(
+                        "'" + samples[i].sensor_id + "'",
+                        use_custom_filter));
+        readers.push_back(dds::sub::DataReader<Temperature>(
+                subscriber,
+                filtered_topic,
+                qos_provider.datareader_qos(profile)));
+    }
+
+    dds::pub::DataWriter<Temperature> writer(
+            dds::pub::Publisher(writer_participant),
+            writer_topic,
+            qos_provider.datawriter_qos(profile));
+
+    // Wait for the DataWriter to discover every DataReader and its filter
+    benchmark::Stopwatch match_stopwatch;
+    while (!shutdown_requested
+           && writer.publication_matched_status().current_count()
+                   < static_cast<int32_t>(reader_count)
+           && match_stopwatch.elapsed_seconds() < MATCH_TIMEOUT_SEC) {
+        rti::util::sleep(dds::core::Duration::from_millisecs(100));
+    }
+
+    // Each sample passes the filter of one DataReader
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int i = 0; i < sample_count && !shutdown_requested; i++) {
+        writer.write(samples[i % reader_count]);
+    }
+
+    benchmark::print_result(
+            std::string(use_custom_filter ? "EqualityIndexFilter"
+                                          : "Builtin SQL filter")
+                    + ", " + std::to_string(reader_count) + " readers",
+            sample_count,
+            stopwatch.elapsed_seconds());
+    rti::core::status::DataWriterProtocolStatus protocol_status =
+            writer.extensions().datawriter_protocol_status();
+    std::cout << "    sent: " << protocol_status.pushed_sample_count()
+              << ", filtered on writer: "
+              << protocol_status.filtered_sample_count() << std::endl;
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        const std::string& transport)
+{
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+
+    dds::domain::qos::DomainParticipantQos participant_qos =
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::BenchmarkProfile",
+                    transport);
+    dds::domain::DomainParticipant writer_participant(
+            domain_id,
+            participant_qos);
+    dds::domain::DomainParticipant reader_participant(
+            domain_id,
+            participant_qos);
+    register_equality_index_filter<Temperature>(writer_participant);
+    register_equality_index_filter<Temperature>(reader_participant);
+
+    std::cout << "Benchmarking " << sample_count
+              << " samples per test, each passing the filter of one reader"
+              << std::endl;
+
+    const unsigned int reader_counts[] = { 10, 100, 1000 };
+    for (unsigned int reader_count : reader_counts) {
+        benchmark_fan_out(
+                reader_count,
+                false,
+                qos_provider,
+                writer_participant,
+                reader_participant,
+                sample_count);
+        benchmark_fan_out(
+                reader_count,
+                true,
+                qos_provider,
+                writer_participant,
+                reader_participant,
+                sample_count);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    // The sample count defaults to infinite, use a finite number of samples
+    unsigned int sample_count = arguments.sample_count
+                    == (std::numeric_limits<unsigned int>::max)()
+            ? DEFAULT_SAMPLE_COUNT
+            : arguments.sample_count;
+
+    try {
+        run_example(arguments.domain_id, sample_count, arguments.transport);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
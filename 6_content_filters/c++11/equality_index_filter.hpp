@@ -0,0 +1,294 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef EQUALITY_INDEX_FILTER_HPP
+#define EQUALITY_INDEX_FILTER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <dds/domain/ddsdomain.hpp>
+#include <dds/topic/ddstopic.hpp>
+#include <rti/topic/ContentFilter.hpp>
+
+#include "chocolate_factory.hpp"
+
+// Custom content filter for equality on one field, such as
+// "next_station = %0" or "sensor_id = %0", for DataWriters with many
+// filtering DataReaders.
+//
+// With the builtin SQL filter, a DataWriter evaluates the filter of every
+// matched DataReader for each sample. This filter instead keeps an index
+// from parameter value to the DataReaders that filter on it: evaluating a
+// sample is one hash table lookup, whatever the number of DataReaders.
+//
+// Like any custom filter, it must be registered with the same name in the
+// DomainParticipants of the DataWriter and of the DataReaders.
+
+// The field that each type is filtered on
+template <typename T>
+struct EqualityFilterField;
+
+template <>
+struct EqualityFilterField<Temperature> {
+    static std::string filter_name()
+    {
+        return "TemperatureSensorIndexFilter";
+    }
+
+    static std::string expression()
+    {
+        return "sensor_id = %0";
+    }
+
+    // sensor_id is the key: the DataWriter can reuse the result of the
+    // filter for all the samples of an instance
+    static bool key_only()
+    {
+        return true;
+    }
+
+    static const std::string& value(const Temperature& sample)
+    {
+        return sample.sensor_id;
+    }
+};
+
+template <>
+struct EqualityFilterField<ChocolateLotState> {
+    static std::string filter_name()
+    {
+        return "LotStationIndexFilter";
+    }
+
+    static std::string expression()
+    {
+        return "next_station = %0";
+    }
+
+    static bool key_only()
+    {
+        return false;
+    }
+
+    // The name of the station, as used in the filter parameter. Returns
+    // a reference to a constant, so that evaluating does not allocate.
+    static const std::string& value(const ChocolateLotState& sample)
+    {
+        static const std::string names[] = { "INVALID_CONTROLLER",
+                                             "COCOA_BUTTER_CONTROLLER",
+                                             "SUGAR_CONTROLLER",
+                                             "MILK_CONTROLLER",
+                                             "VANILLA_CONTROLLER",
+                                             "TEMPERING_CONTROLLER" };
+        size_t index = static_cast<size_t>(sample.next_station);
+        return index < sizeof(names) / sizeof(names[0]) ? names[index]
+                                                        : names[0];
+    }
+};
+
+// Compiled filter of one DataReader: the value the field must be equal to
+struct EqualityFilterValue {
+    std::string value;
+};
+
+// Index of the DataWriter: the DataReaders filtering on each value
+class EqualityFilterIndex {
+public:
+    // Adds or moves the DataReader identified by cookie to value
+    void set(const rti::core::Cookie& cookie, const std::string& value)
+    {
+        remove(cookie);
+        readers_by_value[value].push_back(cookie);
+        reader_values.push_back(std::make_pair(cookie, value));
+    }
+
+    // Removes the DataReader identified by cookie
+    void remove(const rti::core::Cookie& cookie)
+    {
+        for (auto it = reader_values.begin(); it != reader_values.end(); ++it) {
+            if (it->first == cookie) {
+                rti::core::CookieSeq& readers = readers_by_value[it->second];
+                for (auto reader = readers.begin(); reader != readers.end();
+                     ++reader) {
+                    if (*reader == cookie) {
+                        readers.erase(reader);
+                        break;
+                    }
+                }
+                if (readers.empty()) {
+                    readers_by_value.erase(it->second);
+                }
+                reader_values.erase(it);
+                return;
+            }
+        }
+    }
+
+    // The DataReaders that filter on value. The sequence is valid until the
+    // index changes.
+    rti::core::CookieSeq& readers(const std::string& value)
+    {
+        auto it = readers_by_value.find(value);
+        return it != readers_by_value.end() ? it->second : no_readers;
+    }
+
+private:
+    // Looked up for every sample
+    std::unordered_map<std::string, rti::core::CookieSeq> readers_by_value;
+    // Only used when DataReaders match, unmatch, or change parameters
+    std::vector<std::pair<rti::core::Cookie, std::string>> reader_values;
+    rti::core::CookieSeq no_readers;
+};
+
+template <typename T>
+class EqualityIndexFilter : public rti::topic::WriterContentFilter<
+                                    T,
+                                    EqualityFilterValue,
+                                    EqualityFilterIndex> {
+public:
+    // Reader side: the filter of one DataReader
+
+    EqualityFilterValue& compile(
+            const std::string& expression,
+            const dds::core::StringSeq& parameters,
+            const dds::core::optional<dds::core::xtypes::DynamicType>&,
+            const std::string&,
+            EqualityFilterValue *old_compile_data) override
+    {
+        check_expression(expression, parameters);
+        EqualityFilterValue *compiled = old_compile_data != nullptr
+                ? old_compile_data
+                : new EqualityFilterValue();
+        compiled->value = parameter_value(parameters[0]);
+        return *compiled;
+    }
+
+    bool evaluate(
+            EqualityFilterValue& compiled,
+            const T& sample,
+            const rti::topic::FilterSampleInfo&) override
+    {
+        return EqualityFilterField<T>::value(sample) == compiled.value;
+    }
+
+    void finalize(EqualityFilterValue& compiled) override
+    {
+        delete &compiled;
+    }
+
+    // Writer side: the index of all the matched DataReaders
+
+    EqualityFilterIndex& writer_attach() override
+    {
+        return *new EqualityFilterIndex();
+    }
+
+    void writer_detach(EqualityFilterIndex& index) override
+    {
+        delete &index;
+    }
+
+    // Called when a DataReader matches, and when its parameters change
+    void writer_compile(
+            EqualityFilterIndex& index,
+            rti::topic::ExpressionProperty& property,
+            const std::string& expression,
+            const dds::core::StringSeq& parameters,
+            const dds::core::optional<dds::core::xtypes::DynamicType>&,
+            const std::string&,
+            const rti::core::Cookie& cookie) override
+    {
+        check_expression(expression, parameters);
+        property.key_only_filter(EqualityFilterField<T>::key_only());
+        property.writer_side_filter_optimization(true);
+        index.set(cookie, parameter_value(parameters[0]));
+    }
+
+    // Returns the DataReaders that the sample passes: one lookup
+    rti::core::CookieSeq& writer_evaluate(
+            EqualityFilterIndex& index,
+            const T& sample,
+            const rti::topic::FilterSampleInfo&) override
+    {
+        return index.readers(EqualityFilterField<T>::value(sample));
+    }
+
+    void writer_finalize(
+            EqualityFilterIndex& index,
+            const rti::core::Cookie& cookie) override
+    {
+        index.remove(cookie);
+    }
+
+    // writer_evaluate returns a sequence owned by the index: nothing to
+    // release
+    void writer_return_loan(EqualityFilterIndex&, rti::core::CookieSeq&)
+            override
+    {
+    }
+
+private:
+    static void check_expression(
+            const std::string& expression,
+            const dds::core::StringSeq& parameters)
+    {
+        if (expression != EqualityFilterField<T>::expression()
+                || parameters.size() != 1) {
+            throw dds::core::InvalidArgumentError(
+                    EqualityFilterField<T>::filter_name()
+                    + " expects the expression \""
+                    + EqualityFilterField<T>::expression()
+                    + "\" and 1 parameter");
+        }
+    }
+
+    // Parameters are quoted, as for the builtin SQL filter: 'value'
+    static std::string parameter_value(const std::string& parameter)
+    {
+        if (parameter.size() >= 2 && parameter.front() == '\''
+                && parameter.back() == '\'') {
+            return parameter.substr(1, parameter.size() - 2);
+        }
+        return parameter;
+    }
+};
+
+// Registers the filter for type T in a DomainParticipant
+template <typename T>
+void register_equality_index_filter(dds::domain::DomainParticipant& participant)
+{
+    participant->register_contentfilter(
+            rti::topic::CustomFilter<EqualityIndexFilter<T>>(
+                    new EqualityIndexFilter<T>()),
+            EqualityFilterField<T>::filter_name());
+}
+
+// Creates the equality filter for a ContentFilteredTopic of type T, using
+// either the builtin SQL filter or the EqualityIndexFilter
+template <typename T>
+dds::topic::Filter equality_filter(
+        const std::string& parameter,
+        bool use_custom_filter)
+{
+    dds::topic::Filter filter(
+            EqualityFilterField<T>::expression(),
+            { parameter });
+    if (use_custom_filter) {
+        filter->name(EqualityFilterField<T>::filter_name());
+    }
+    return filter;
+}
+
+#endif  // EQUALITY_INDEX_FILTER_HPP
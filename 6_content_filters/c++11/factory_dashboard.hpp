@@ -0,0 +1,439 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef FACTORY_DASHBOARD_HPP
+#define FACTORY_DASHBOARD_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "chocolate_factory.hpp"
+#include "chocolate_factory_format.hpp"
+#include "lot_table.hpp"
+#include "pipeline_kpis.hpp"
+
+// Stream buffer for the messages of another thread, such as the writer
+// thread of the log. What it has written is passed on when it flushes.
+class SharedMessageBuffer : public std::stringbuf {
+public:
+    // Takes the text flushed so far
+    std::string take()
+    {
+        std::string taken;
+        std::lock_guard<std::mutex> lock(mutex);
+        taken.swap(flushed);
+        return taken;
+    }
+
+protected:
+    int sync() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        flushed += str();
+        str(std::string());
+        return 0;
+    }
+
+private:
+    std::mutex mutex;
+    std::string flushed;
+};
+
+// Terminal dashboard of the monitoring application, instead of a line of
+// output per sample. The handlers only update counters, and the screen is
+// drawn from them, the lot table and the station KPIs once per refresh
+// period: drawing costs the same at any sample rate.
+//
+// The screen has a fixed number of lines. Each frame moves the cursor to the
+// top left corner and overwrites the previous one, with ANSI escape
+// sequences. Messages that would be printed, such as reports and
+// statistics, are written to messages() instead, or to log_messages() by
+// other threads, and the last ones are shown at the bottom of the screen.
+class FactoryDashboard {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    // Stuck lots listed on the screen, the longest at their station first
+    static const size_t STUCK_LOTS_SHOWN = 5;
+
+    // Lines of messages shown on the screen, the newest last
+    static const size_t MESSAGE_LINES = 10;
+
+    // A lot is stuck when it has been at its station for stuck_threshold.
+    // all_readings tells whether every temperature reading is received, or
+    // only those that pass the out-of-range filter.
+    FactoryDashboard(clock::duration stuck_threshold, bool all_readings)
+            : stuck_threshold(stuck_threshold),
+              all_readings(all_readings),
+              start_time(clock::now()),
+              interval_start(start_time),
+              interval_out_of_range(0),
+              last_anomaly_started(false),
+              first_frame(true),
+              log_stream(&log_buffer)
+    {
+    }
+
+    // Records the readings received from a sensor: one reading, or the
+    // readings of a summary
+    void temperature_received(
+            int32_t min_degrees,
+            int32_t max_degrees,
+            uint64_t count = 1)
+    {
+        interval_temperatures.add(min_degrees, max_degrees, count);
+        total_temperatures.add(min_degrees, max_degrees, count);
+    }
+
+    void temperature_out_of_range(
+            const std::string& sensor_id,
+            int32_t min_degrees,
+            int32_t max_degrees)
+    {
+        interval_out_of_range++;
+        last_out_of_range.sensor_id = sensor_id;
+        last_out_of_range.min_degrees = min_degrees;
+        last_out_of_range.max_degrees = max_degrees;
+    }
+
+    void temperature_anomaly(const Temperature& temperature, bool started)
+    {
+        if (started) {
+            anomaly_counts.started++;
+        } else {
+            anomaly_counts.ended++;
+        }
+        last_anomaly.sensor_id = temperature.sensor_id;
+        last_anomaly.min_degrees = temperature.degrees;
+        last_anomaly.max_degrees = temperature.degrees;
+        last_anomaly_started = started;
+    }
+
+    // Stream of the messages shown on the screen. Each complete line is
+    // shown from the next frame on.
+    std::ostream& messages()
+    {
+        return message_stream;
+    }
+
+    // Stream of the messages of another thread, such as the writer thread of
+    // the log. The lines are shown once it flushes them.
+    std::ostream& log_messages()
+    {
+        return log_stream;
+    }
+
+    // Draws a frame, and starts a new interval for the temperature rates
+    void draw(
+            const LotTable& lot_table,
+            PipelineKpis& kpis,
+            clock::time_point now,
+            std::ostream& out)
+    {
+        frame.str(std::string());
+        frame << std::fixed << std::setprecision(1);
+        if (first_frame) {
+            // Clear the screen
+            frame << "\x1b[2J";
+            first_frame = false;
+        }
+        // Cursor to the top left corner
+        frame << "\x1b[H";
+
+        uint64_t uptime_sec = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::seconds>(
+                        now - start_time)
+                        .count());
+        frame << "Chocolate factory monitor, up " << uptime_sec / 3600 << ":"
+              << std::setfill('0') << std::setw(2) << uptime_sec / 60 % 60
+              << ":" << std::setw(2) << uptime_sec % 60 << std::setfill(' ');
+        end_line();
+        frame << "Lots tracked: " << lot_table.size() << " of "
+              << lot_table.capacity() << ", waiting: "
+              << lot_table.count_with_status(LotStatusKind::WAITING)
+              << ", processing: "
+              << lot_table.count_with_status(LotStatusKind::PROCESSING)
+              << ", completed: "
+              << lot_table.count_with_status(LotStatusKind::COMPLETED);
+        end_line();
+        end_line();
+
+        draw_stations(lot_table, kpis, now);
+        end_line();
+        draw_temperatures(now);
+        end_line();
+        draw_messages();
+
+        // Clear what is left of the previous frame
+        frame << "\x1b[J";
+        out << frame.str() << std::flush;
+    }
+
+private:
+    // Readings of an interval, or since the start
+    struct TemperatureStats {
+        TemperatureStats() : count(0), min_degrees(0), max_degrees(0)
+        {
+        }
+
+        void add(int32_t min, int32_t max, uint64_t readings)
+        {
+            if (count == 0 || min < min_degrees) {
+                min_degrees = min;
+            }
+            if (count == 0 || max > max_degrees) {
+                max_degrees = max;
+            }
+            count += readings;
+        }
+
+        uint64_t count;
+        int32_t min_degrees;
+        int32_t max_degrees;
+    };
+
+    // A reading, or the range of the readings of a summary
+    struct SensorReading {
+        SensorReading() : min_degrees(0), max_degrees(0)
+        {
+        }
+
+        std::string sensor_id;
+        int32_t min_degrees;
+        int32_t max_degrees;
+    };
+
+    struct AnomalyCounts {
+        AnomalyCounts() : started(0), ended(0)
+        {
+        }
+
+        uint64_t started;
+        uint64_t ended;
+    };
+
+    struct StuckLot {
+        uint32_t lot_id;
+        StationKind station;
+        double seconds;
+    };
+
+    static double seconds(clock::duration duration)
+    {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    static size_t station_index(StationKind station)
+    {
+        size_t index = static_cast<size_t>(station);
+        return index < LotTable::STATION_COUNT ? index : 0;
+    }
+
+    // Clears the rest of the line, in case the previous frame was longer
+    void end_line()
+    {
+        frame << "\x1b[K\n";
+    }
+
+    void draw_stations(
+            const LotTable& lot_table,
+            PipelineKpis& kpis,
+            clock::time_point now)
+    {
+        // Stuck lots per station, and the ones stuck the longest, by
+        // insertion into a short sorted array
+        size_t stuck_counts[LotTable::STATION_COUNT] = {};
+        size_t stuck_total = 0;
+        StuckLot longest[STUCK_LOTS_SHOWN];
+        size_t longest_count = 0;
+        kpis.for_each_stuck(
+                now,
+                stuck_threshold,
+                [&](uint32_t lot_id, StationKind station, double sec) {
+                    stuck_counts[station_index(station)]++;
+                    stuck_total++;
+                    if (longest_count == STUCK_LOTS_SHOWN
+                        && longest[longest_count - 1].seconds >= sec) {
+                        return;
+                    }
+                    size_t i = longest_count < STUCK_LOTS_SHOWN
+                            ? longest_count++
+                            : longest_count - 1;
+                    while (i > 0 && longest[i - 1].seconds < sec) {
+                        longest[i] = longest[i - 1];
+                        i--;
+                    }
+                    longest[i] = { lot_id, station, sec };
+                });
+
+        bool header = true;
+        kpis.report(lot_table, now, [&](const StationKpi& kpi) {
+            if (header) {
+                std::string title = "Station (last "
+                        + std::to_string(kpi.window_sec) + " s)";
+                frame << std::left << std::setw(26) << title << std::right
+                      << std::setw(7) << "Lots" << std::setw(7) << "Stuck"
+                      << std::setw(10) << "Done/s" << std::setw(17)
+                      << "Time in station" << std::setw(13) << "Utilization";
+                end_line();
+                header = false;
+            }
+            frame << std::left << std::setw(26)
+                  << station_kind_name(kpi.station) << std::right
+                  << std::setw(7) << kpi.work_in_progress
+                  << std::setw(7) << stuck_counts[station_index(kpi.station)]
+                  << std::setw(10) << kpi.throughput_per_sec << std::setw(15)
+                  << kpi.mean_time_in_station_sec << " s" << std::setw(13)
+                  << kpi.utilization;
+            end_line();
+        });
+        end_line();
+
+        frame << "Stuck lots (at their station for "
+              << seconds(stuck_threshold) << " s or more): " << stuck_total;
+        end_line();
+        for (size_t i = 0; i < STUCK_LOTS_SHOWN; i++) {
+            if (i < longest_count) {
+                frame << "    lot " << longest[i].lot_id << " at "
+                      << station_kind_name(longest[i].station) << " for "
+                      << longest[i].seconds << " s";
+            }
+            end_line();
+        }
+    }
+
+    void draw_temperatures(clock::time_point now)
+    {
+        double interval_sec = seconds(now - interval_start);
+        if (interval_sec <= 0) {
+            interval_sec = 1;
+        }
+        if (all_readings) {
+            frame << "Temperature readings: "
+                  << interval_temperatures.count / interval_sec
+                  << "/s, out of range: "
+                  << interval_out_of_range / interval_sec
+                  << "/s, anomalies started: " << anomaly_counts.started
+                  << ", ended: " << anomaly_counts.ended;
+        } else {
+            // The filter only passes the readings out of range
+            frame << "Temperature readings out of range: "
+                  << interval_temperatures.count / interval_sec
+                  << "/s (-a receives every reading)";
+        }
+        end_line();
+        frame << "    since last refresh: ";
+        draw_extremes(interval_temperatures);
+        frame << ", since start: ";
+        draw_extremes(total_temperatures);
+        end_line();
+        frame << "    last out of range: ";
+        draw_reading(last_out_of_range);
+        end_line();
+        frame << "    last anomaly: ";
+        draw_reading(last_anomaly);
+        if (!last_anomaly.sensor_id.empty()) {
+            frame << (last_anomaly_started ? " (started)" : " (ended)");
+        }
+        end_line();
+
+        interval_start = now;
+        interval_temperatures = TemperatureStats();
+        interval_out_of_range = 0;
+    }
+
+    // Adds the complete lines of text to the lines shown, and returns the
+    // incomplete last line
+    std::string add_messages(const std::string& text)
+    {
+        size_t line_start = 0;
+        for (size_t end = text.find('\n'); end != std::string::npos;
+             end = text.find('\n', line_start)) {
+            recent_messages.push_back(
+                    text.substr(line_start, end - line_start));
+            if (recent_messages.size() > MESSAGE_LINES) {
+                recent_messages.pop_front();
+            }
+            line_start = end + 1;
+        }
+        return text.substr(line_start);
+    }
+
+    // Moves the complete lines written to the message streams to the lines
+    // shown
+    void draw_messages()
+    {
+        // The log flushes whole messages
+        add_messages(log_buffer.take());
+        message_stream.str(add_messages(message_stream.str()));
+        // Write after the incomplete line, not over it
+        message_stream.seekp(0, std::ios_base::end);
+
+        frame << "Messages:";
+        end_line();
+        for (size_t i = 0; i < MESSAGE_LINES; i++) {
+            if (i < recent_messages.size()) {
+                frame << "    " << recent_messages[i];
+            }
+            end_line();
+        }
+    }
+
+    void draw_extremes(const TemperatureStats& stats)
+    {
+        if (stats.count == 0) {
+            frame << "no readings";
+            return;
+        }
+        frame << "min " << stats.min_degrees << ", max " << stats.max_degrees;
+    }
+
+    void draw_reading(const SensorReading& reading)
+    {
+        if (reading.sensor_id.empty()) {
+            frame << "none";
+            return;
+        }
+        frame << "sensor " << reading.sensor_id << ": " << reading.min_degrees;
+        if (reading.max_degrees != reading.min_degrees) {
+            frame << " to " << reading.max_degrees;
+        }
+    }
+
+    clock::duration stuck_threshold;
+    bool all_readings;
+    clock::time_point start_time;
+    clock::time_point interval_start;
+    TemperatureStats interval_temperatures;
+    TemperatureStats total_temperatures;
+    uint64_t interval_out_of_range;
+    SensorReading last_out_of_range;
+    SensorReading last_anomaly;
+    bool last_anomaly_started;
+    AnomalyCounts anomaly_counts;
+    bool first_frame;
+    // Reused for every frame, which is written to the terminal at once
+    std::ostringstream frame;
+    std::ostringstream message_stream;
+    SharedMessageBuffer log_buffer;
+    // After log_buffer, which it writes to
+    std::ostream log_stream;
+    std::deque<std::string> recent_messages;
+};
+
+#endif  // FACTORY_DASHBOARD_HPP
@@ -0,0 +1,127 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef FILTER_PARAMETER_UPDATE_HPP
+#define FILTER_PARAMETER_UPDATE_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dds/sub/ddssub.hpp>
+#include <dds/topic/ddstopic.hpp>
+
+#include "chocolate_factory.hpp"
+
+// Helpers for the FilterParameterUpdate control Topic. The monitoring
+// application publishes the new parameters of a ContentFilteredTopic, and the
+// applications that use it set them on their existing ContentFilteredTopic.
+// No entity is recreated: the DataReader keeps its matched DataWriters, and
+// DataWriters that filter for it receive the new parameters with discovery.
+
+// Converts the name of a station to a StationKind. "ALL" is converted to
+// INVALID_CONTROLLER, which targets every application. Returns false for
+// other names.
+inline bool station_kind_from_string(
+        const std::string& name,
+        StationKind& station_kind)
+{
+    if (name == "ALL") {
+        station_kind = StationKind::INVALID_CONTROLLER;
+    } else if (name == "COCOA_BUTTER_CONTROLLER") {
+        station_kind = StationKind::COCOA_BUTTER_CONTROLLER;
+    } else if (name == "SUGAR_CONTROLLER") {
+        station_kind = StationKind::SUGAR_CONTROLLER;
+    } else if (name == "MILK_CONTROLLER") {
+        station_kind = StationKind::MILK_CONTROLLER;
+    } else if (name == "VANILLA_CONTROLLER") {
+        station_kind = StationKind::VANILLA_CONTROLLER;
+    } else if (name == "TEMPERING_CONTROLLER") {
+        station_kind = StationKind::TEMPERING_CONTROLLER;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Creates a DataReader that receives the updates of the ContentFilteredTopic
+// filter_name: those for the station of this application, and those for
+// every application. station_kind is the name of the station, or
+// "INVALID_CONTROLLER" for applications that are not a station.
+inline dds::sub::DataReader<FilterParameterUpdate>
+create_filter_parameter_reader(
+        dds::sub::Subscriber& subscriber,
+        dds::topic::Topic<FilterParameterUpdate>& topic,
+        dds::core::QosProvider& qos_provider,
+        const std::string& filter_name,
+        const std::string& station_kind)
+{
+    dds::topic::ContentFilteredTopic<FilterParameterUpdate> filtered_topic(
+            topic,
+            filter_name + "ParameterUpdate",
+            dds::topic::Filter(
+                    "filter_name = %0 and (station = %1 "
+                    "or station = 'INVALID_CONTROLLER')",
+                    { "'" + filter_name + "'", "'" + station_kind + "'" }));
+
+    return dds::sub::DataReader<FilterParameterUpdate>(
+            subscriber,
+            filtered_topic,
+            qos_provider.datareader_qos(
+                    "ChocolateFactoryLibrary::FilterParameterUpdateProfile"));
+}
+
+// Takes the received updates. Returns true, with the parameters of the
+// newest update, when there was at least one.
+inline bool take_filter_parameters(
+        dds::sub::DataReader<FilterParameterUpdate>& reader,
+        std::vector<std::string>& parameters)
+{
+    bool updated = false;
+    dds::sub::LoanedSamples<FilterParameterUpdate> samples = reader.take();
+    for (const auto& sample : samples) {
+        if (sample.info().valid()) {
+            parameters.assign(
+                    sample.data().parameters.begin(),
+                    sample.data().parameters.end());
+            updated = true;
+        }
+    }
+    return updated;
+}
+
+// Sets new parameters on an existing ContentFilteredTopic, and reports it to
+// out. Parameters that are not valid for its filter expression are reported
+// and ignored, and the previous parameters stay in use.
+template <typename T>
+bool update_filter_parameters(
+        dds::topic::ContentFilteredTopic<T>& filtered_topic,
+        const std::vector<std::string>& parameters,
+        std::ostream& out = std::cout)
+{
+    try {
+        filtered_topic.filter_parameters(parameters.begin(), parameters.end());
+    } catch (const std::exception& ex) {
+        out << "Ignoring parameters for " << filtered_topic.name() << ": "
+            << ex.what() << std::endl;
+        return false;
+    }
+
+    out << "Updated " << filtered_topic.name() << " parameters:";
+    for (const auto& parameter : parameters) {
+        out << " " << parameter;
+    }
+    out << std::endl;
+    return true;
+}
+
+#endif  // FILTER_PARAMETER_UPDATE_HPP
@@ -0,0 +1,77 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef FILTER_STATISTICS_HPP
+#define FILTER_STATISTICS_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+
+// Statistics that show where content filters are evaluated, and how much
+// they save.
+//
+// A DataWriter evaluates the filters of the matched DataReaders that it can
+// filter for. The samples that do not pass are not sent: they are counted,
+// with their size, in the DataWriter protocol status.
+// A DataReader evaluates its filter on the samples the DataWriter did not
+// filter. The samples that do not pass are counted in the DataReader cache
+// status.
+// A DataReader that drops almost no samples while its DataWriters filter
+// many shows that the filter is evaluated on the writer side.
+
+// Prints the content filter statistics of a DataReader: the samples it
+// received, and how many of them passed its filter
+template <typename T>
+void print_reader_filter_statistics(
+        dds::sub::DataReader<T>& reader,
+        std::ostream& out = std::cout)
+{
+    rti::core::status::DataReaderProtocolStatus protocol_status =
+            reader.extensions().datareader_protocol_status();
+    uint64_t received = protocol_status.received_sample_count();
+    uint64_t filtered = reader.extensions()
+                                .datareader_cache_status()
+                                .content_filter_dropped_sample_count();
+
+    out << "Filter statistics of DataReader "
+        << reader.topic_description().name()
+        << ": received: " << received
+        << " (" << protocol_status.received_sample_bytes() << " bytes)"
+        << ", passed: " << received - filtered
+        << ", filtered on reader: " << filtered << std::endl;
+}
+
+// Prints the content filter statistics of a DataWriter: the samples it sent,
+// and the samples and bytes it did not send because the filters of the
+// matched DataReaders did not pass them
+template <typename T>
+void print_writer_filter_statistics(
+        dds::pub::DataWriter<T>& writer,
+        std::ostream& out = std::cout)
+{
+    rti::core::status::DataWriterProtocolStatus protocol_status =
+            writer.extensions().datawriter_protocol_status();
+
+    out << "Filter statistics of DataWriter " << writer.topic().name()
+        << ": sent: " << protocol_status.pushed_sample_count() << " ("
+        << protocol_status.pushed_sample_bytes() << " bytes)"
+        << ", filtered on writer: "
+        << protocol_status.filtered_sample_count()
+        << ", bytes saved: " << protocol_status.filtered_sample_bytes()
+        << std::endl;
+}
+
+#endif  // FILTER_STATISTICS_HPP
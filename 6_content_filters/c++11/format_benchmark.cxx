@@ -0,0 +1,119 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "benchmark.hpp"  // Stopwatch and result printing
+#include "chocolate_factory_format.hpp"  // Allocation-free sample text
+
+using namespace application;
+
+// Sample formatting benchmark:
+// Compares, for ChocolateLotState and Temperature samples:
+// 1) Before: the generated operator<<, into a std::ostringstream that is
+//    reused, and whose text is copied out as the log did
+// 2) After: format_sample(), into a buffer on the stack
+//
+// -s, --sample-count sets how many samples are formatted.
+
+const unsigned int DEFAULT_SAMPLE_COUNT = 1000000;
+
+// Different samples, so that the formatting cannot be hoisted from the loop
+const unsigned int DISTINCT_SAMPLES = 1024;
+
+void fill_sample(ChocolateLotState& sample, unsigned int index)
+{
+    sample.lot_id = index;
+    sample.station = StationKind::SUGAR_CONTROLLER;
+    sample.next_station = StationKind::MILK_CONTROLLER;
+    sample.lot_status = LotStatusKind::PROCESSING;
+}
+
+void fill_sample(Temperature& sample, unsigned int index)
+{
+    sample.sensor_id = std::to_string(index % 50);
+    sample.degrees = 30 + static_cast<int32_t>(index % 3);
+}
+
+template <typename T>
+void benchmark_type(const std::string& type_label, unsigned int sample_count)
+{
+    std::vector<T> samples(DISTINCT_SAMPLES);
+    for (unsigned int i = 0; i < DISTINCT_SAMPLES; i++) {
+        fill_sample(samples[i], i);
+    }
+
+    // The lengths are added up, so that the text is used
+    size_t stream_length = 0;
+    std::ostringstream stream;
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int i = 0; i < sample_count; i++) {
+        stream.str(std::string());
+        stream << samples[i % DISTINCT_SAMPLES];
+        stream_length += stream.str().size();
+    }
+    benchmark::print_result(
+            type_label + " operator<<",
+            sample_count,
+            stopwatch.elapsed_seconds());
+
+    size_t buffer_length = 0;
+    char buffer[SAMPLE_TEXT_SIZE];
+    stopwatch.restart();
+    for (unsigned int i = 0; i < sample_count; i++) {
+        buffer_length += format_sample(
+                samples[i % DISTINCT_SAMPLES],
+                buffer,
+                sizeof(buffer));
+    }
+    benchmark::print_result(
+            type_label + " format_sample",
+            sample_count,
+            stopwatch.elapsed_seconds());
+
+    std::cout << "    characters: " << stream_length << " with operator<<, "
+              << buffer_length << " with format_sample" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    // The sample count defaults to infinite, use a finite number of samples
+    unsigned int sample_count = arguments.sample_count
+                    == (std::numeric_limits<unsigned int>::max)()
+            ? DEFAULT_SAMPLE_COUNT
+            : arguments.sample_count;
+
+    std::cout << "Benchmarking " << sample_count << " samples of each type"
+              << std::endl;
+    benchmark_type<ChocolateLotState>("ChocolateLotState", sample_count);
+    benchmark_type<Temperature>("Temperature", sample_count);
+    return EXIT_SUCCESS;
+}
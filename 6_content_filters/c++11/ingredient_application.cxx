@@ -21,6 +21,11 @@
 
 #include "chocolate_factory.hpp"
 #include "application.hpp"  // Argument parsing
+#include "equality_index_filter.hpp"  // Indexed next_station filter
+#include "filter_parameter_update.hpp"  // Runtime filter parameters
+#include "filter_statistics.hpp"  // Content filter statistics
+#include "statistics_period.hpp"  // Periodic tasks
+#include "instance_statistics.hpp"  // Live and purged instances
 
 using namespace application;
 
@@ -28,8 +33,11 @@ using namespace application;
 // 1) Subscribes to the lot state
 // 2) "Processes" the lot. (In this example, that means sleep for a time)
 // 3) After "processing" the lot, publishes an updated lot state
+// The monitoring application can change the parameters of the lot filter
+// at runtime, with the FilterParameterUpdate Topic.
 
-void process_lot(
+// Returns the number of lots processed
+unsigned int process_lot(
         const StationKind station_kind,
         const std::map<StationKind, StationKind>& next_station,
         dds::sub::DataReader<ChocolateLotState>& lot_state_reader,
@@ -41,6 +49,7 @@ void process_lot(
             lot_state_reader.take();
 
     // Process lots waiting for ingredients
+    unsigned int lots_processed = 0;
     for (const auto& sample : samples) {
         if (!sample.info().valid() || shutdown_requested) {
             break;
@@ -49,7 +58,7 @@ void process_lot(
         // No need to check that this is the next station: content filter
         // ensures that the reader only receives lots with
         // next_station == this station
-        std::cout << "Processing lot #" << sample.data().lot_id << std::endl;
+        log_message(LogLevel::info, "Processing lot #", sample.data().lot_id);
 
         // Send an update that this station is processing lot
         ChocolateLotState updated_state(sample.data());
@@ -65,8 +74,16 @@ void process_lot(
         updated_state.lot_status = LotStatusKind::COMPLETED;
         updated_state.next_station = next_station.at(station_kind);
         updated_state.station = station_kind;
-        lot_state_writer.write(updated_state);
+        dds::core::InstanceHandle instance_handle =
+                lot_state_writer.register_instance(updated_state);
+        lot_state_writer.write(updated_state, instance_handle);
+
+        // The lot is handed over to the next station: unregister it, so that
+        // the DataWriter does not keep every lot it has processed
+        lot_state_writer.unregister_instance(instance_handle);
+        lots_processed++;
     }
+    return lots_processed;
 }  // The LoanedSamples destructor returns the loan
 
 StationKind string_to_stationkind(const std::string& station_kind)
@@ -83,7 +100,12 @@ StationKind string_to_stationkind(const std::string& station_kind)
     return StationKind::INVALID_CONTROLLER;
 }
 
-void run_example(unsigned int domain_id, const std::string& station_kind)
+void run_example(
+        unsigned int domain_id,
+        const std::string& station_kind,
+        const std::string& transport,
+        unsigned int statistics_period_sec,
+        bool use_custom_filter)
 {
     StationKind current_station = string_to_stationkind(station_kind);
     std::cout << station_kind << " station starting" << std::endl;
@@ -103,8 +125,14 @@ void run_example(unsigned int domain_id, const std::string& station_kind)
     // Uses IngredientApplication QoS profile to set participant name.
     dds::domain::DomainParticipant participant(
             domain_id,
-            qos_provider.participant_qos(
-                    "ChocolateFactoryLibrary::IngredientApplication"));
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::IngredientApplication",
+                    transport));
+
+    // Register the indexed next_station filter, so that the DataWriter of
+    // this and the other applications can filter for the DataReader
+    register_equality_index_filter<ChocolateLotState>(participant);
 
     // A Topic has a name and a datatype. Create Topics.
     // Topic names are constants defined in the IDL file.
@@ -116,7 +144,13 @@ void run_example(unsigned int domain_id, const std::string& station_kind)
             filtered_lot_state_topic(
                     lot_state_topic,
                     "FilteredLot",
-                    dds::topic::Filter("next_station = %0", { filter_value }));
+                    equality_filter<ChocolateLotState>(
+                            filter_value,
+                            use_custom_filter));
+    // Receives new parameters for the lot filter
+    dds::topic::Topic<FilterParameterUpdate> filter_parameter_topic(
+            participant,
+            FILTER_PARAMETER_UPDATE_TOPIC);
 
     // A Publisher allows an application to create one or more DataWriters
     // Create Publisher with default QoS
@@ -141,6 +175,19 @@ void run_example(unsigned int domain_id, const std::string& station_kind)
             qos_provider.datareader_qos(
                     "ChocolateFactoryLibrary::ChocolateLotStateProfile"));
 
+    // Create DataReader of the updates to the "FilteredLot" parameters
+    // for this station
+    dds::sub::DataReader<FilterParameterUpdate> filter_parameter_reader(
+            create_filter_parameter_reader(
+                    subscriber,
+                    filter_parameter_topic,
+                    qos_provider,
+                    filtered_lot_state_topic.name(),
+                    station_kind));
+
+    // Lots processed so far, for the instance statistics
+    unsigned int lots_processed = 0;
+
     // Obtain the DataReader's Status Condition
     dds::core::cond::StatusCondition reader_status_condition(lot_state_reader);
 
@@ -155,7 +202,7 @@ void run_example(unsigned int domain_id, const std::string& station_kind)
     reader_status_condition.extensions().handler([&]() {
         if ((lot_state_reader.status_changes() & StatusMask::data_available())
                 != StatusMask::none()) {
-            process_lot(
+            lots_processed += process_lot(
                     current_station,
                     next_station,
                     lot_state_reader,
@@ -163,14 +210,40 @@ void run_example(unsigned int domain_id, const std::string& station_kind)
         }
     });
 
+    // Apply new filter parameters in place: the DataReader and its matches
+    // are kept, and lots are filtered with the new parameters from now on
+    dds::core::cond::StatusCondition filter_parameter_status_condition(
+            filter_parameter_reader);
+    filter_parameter_status_condition.enabled_statuses(
+            StatusMask::data_available());
+    filter_parameter_status_condition.extensions().handler([&]() {
+        std::vector<std::string> parameters;
+        if (take_filter_parameters(filter_parameter_reader, parameters)) {
+            update_filter_parameters(filtered_lot_state_topic, parameters);
+        }
+    });
+
     // Create a WaitSet and attach the StatusCondition
     dds::core::cond::WaitSet waitset;
     waitset += reader_status_condition;
+    waitset += filter_parameter_status_condition;
 
+    // Print how many lots the filters drop, and where, and how many lot
+    // instances are kept, every statistics_period_sec seconds
+    StatisticsPeriod statistics_period(statistics_period_sec);
     while (!shutdown_requested) {
         // Wait for ChocolateLotState
-        std::cout << "Waiting for lot" << std::endl;
-        waitset.dispatch(dds::core::Duration(10));  // Wait up to 10s for update
+        log_message(LogLevel::info, "Waiting for lot");
+        // Wait up to 10s for update
+        waitset.dispatch(statistics_period.wait_time(dds::core::Duration(10)));
+        if (statistics_period.due()) {
+            print_reader_filter_statistics(lot_state_reader);
+            print_writer_filter_statistics(lot_state_writer);
+            // Each lot processed ends an instance in both: the DataWriter
+            // unregisters it, and so does the previous station
+            print_reader_instance_statistics(lot_state_reader, lots_processed);
+            print_writer_instance_statistics(lot_state_writer, lots_processed);
+        }
     }
 }
 
@@ -188,8 +261,16 @@ int main(int argc, char *argv[])
     // Sets Connext verbosity to help debugging
     rti::config::Logger::instance().verbosity(arguments.verbosity);
 
+    // Writes the log messages of the data paths in the background
+    LogWriter log_writer(arguments.log_level);
+
     try {
-        run_example(arguments.domain_id, arguments.station_kind);
+        run_example(
+                arguments.domain_id,
+                arguments.station_kind,
+                arguments.transport,
+                arguments.statistics_period_sec,
+                arguments.use_custom_filter);
     } catch (const std::exception& ex) {
         // This will catch DDS exceptions
         std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
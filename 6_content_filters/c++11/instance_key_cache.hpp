@@ -0,0 +1,84 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef INSTANCE_KEY_CACHE_HPP
+#define INSTANCE_KEY_CACHE_HPP
+
+#include <cstdint>
+#include <map>
+
+#include <dds/core/ddscore.hpp>
+
+// Key of each instance of a DataReader, by instance handle. Samples without
+// data, such as those of a disposed instance, only have its handle: the cache
+// finds the key with a map lookup instead of DataReader::key_value(). The
+// map is ordered with InstanceHandle::operator<, as in rolling_quantiles.hpp
+// and anomaly_detector.hpp.
+//
+// A handle is derived from the key hash, so it always identifies the same
+// instance: an entry is never stale. Keys are added with the valid samples of
+// the instance, and removed when the instance is disposed or has no writers,
+// to keep the cache bounded.
+template <typename Key>
+class InstanceKeyCache {
+public:
+    InstanceKeyCache() : hit_count(0), miss_count(0)
+    {
+    }
+
+    void insert(const dds::core::InstanceHandle& handle, const Key& key)
+    {
+        keys[handle] = key;
+    }
+
+    // Finds the key of an instance and removes it from the cache. Returns
+    // false, and counts a miss, if it is not in the cache.
+    bool take(const dds::core::InstanceHandle& handle, Key& key)
+    {
+        auto it = keys.find(handle);
+        if (it == keys.end()) {
+            miss_count++;
+            return false;
+        }
+        hit_count++;
+        key = it->second;
+        keys.erase(it);
+        return true;
+    }
+
+    void remove(const dds::core::InstanceHandle& handle)
+    {
+        keys.erase(handle);
+    }
+
+    size_t size() const
+    {
+        return keys.size();
+    }
+
+    uint64_t hits() const
+    {
+        return hit_count;
+    }
+
+    uint64_t misses() const
+    {
+        return miss_count;
+    }
+
+private:
+    std::map<dds::core::InstanceHandle, Key> keys;
+    uint64_t hit_count;
+    uint64_t miss_count;
+};
+
+#endif  // INSTANCE_KEY_CACHE_HPP
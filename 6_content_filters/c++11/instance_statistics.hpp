@@ -0,0 +1,92 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef INSTANCE_STATISTICS_HPP
+#define INSTANCE_STATISTICS_HPP
+
+#include <cstdint>
+#include <iostream>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+
+// Statistics that show whether the instance tables stay bounded.
+//
+// Live instances are the lots in progress. A completed lot is disposed and
+// unregistered; its instance is then kept until the purge delays of the
+// QoS profile elapse. With the purge working, the counts and their peaks
+// stay flat however many lots have been processed, and the instances purged
+// keep pace with those that have ended.
+
+// Instances purged so far: those that have ended, less those still waiting
+// to be purged
+inline uint64_t purged_instances(uint64_t ended, uint64_t waiting)
+{
+    return ended > waiting ? ended - waiting : 0;
+}
+
+// Prints the instances in the cache of a DataReader: live, waiting to be
+// purged, and purged out of ended_instances, those disposed or left without
+// writers so far
+template <typename T>
+void print_reader_instance_statistics(
+        dds::sub::DataReader<T>& reader,
+        uint64_t ended_instances,
+        std::ostream& out = std::cout)
+{
+    rti::core::status::DataReaderCacheStatus status =
+            reader.extensions().datareader_cache_status();
+
+    out << "Instance statistics of DataReader "
+        << reader.topic_description().name()
+        << ": live: " << status.alive_instance_count()
+        << " (peak " << status.alive_instance_count_peak() << ")"
+        << ", disposed: " << status.disposed_instance_count()
+        << ", no writers: " << status.no_writers_instance_count()
+        << ", purged: "
+        << purged_instances(
+                   ended_instances,
+                   status.disposed_instance_count()
+                           + status.no_writers_instance_count())
+        << " of " << ended_instances << ", samples: "
+        << status.sample_count() << " (peak " << status.sample_count_peak()
+        << ")" << std::endl;
+}
+
+// Prints the instances in the queue of a DataWriter: live, unregistered or
+// disposed but not yet purged, and purged out of ended_instances, those
+// unregistered or disposed so far
+template <typename T>
+void print_writer_instance_statistics(
+        dds::pub::DataWriter<T>& writer,
+        uint64_t ended_instances,
+        std::ostream& out = std::cout)
+{
+    rti::core::status::DataWriterCacheStatus status =
+            writer.extensions().datawriter_cache_status();
+
+    out << "Instance statistics of DataWriter " << writer.topic().name()
+        << ": live: " << status.alive_instance_count()
+        << " (peak " << status.alive_instance_count_peak() << ")"
+        << ", unregistered: " << status.unregistered_instance_count()
+        << ", disposed: " << status.disposed_instance_count()
+        << ", purged: "
+        << purged_instances(
+                   ended_instances,
+                   status.unregistered_instance_count()
+                           + status.disposed_instance_count())
+        << " of " << ended_instances << ", samples: "
+        << status.sample_count() << " (peak " << status.sample_count_peak()
+        << ")" << std::endl;
+}
+
+#endif  // INSTANCE_STATISTICS_HPP
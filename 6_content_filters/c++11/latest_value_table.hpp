@@ -0,0 +1,103 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef LATEST_VALUE_TABLE_HPP
+#define LATEST_VALUE_TABLE_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dds/core/ddscore.hpp>
+
+#include "chocolate_factory.hpp"
+
+// Keeps only the newest temperature reading of each sensor until the
+// application processes it. A reading that is replaced before it was
+// processed is counted as superseded.
+class LatestTemperatureTable {
+public:
+    LatestTemperatureTable()
+            : received_count(0), superseded_count(0), processed_count(0)
+    {
+    }
+
+    // Stores a reading and the instance of its sensor, replacing the pending
+    // reading of the same sensor
+    void update(
+            const Temperature& reading,
+            const dds::core::InstanceHandle& instance_handle)
+    {
+        received_count++;
+        Entry& entry = entries[reading.sensor_id];
+        if (entry.pending) {
+            superseded_count++;
+        } else {
+            entry.pending = true;
+            // Pointers to unordered_map elements stay valid on rehash
+            pending_entries.push_back(&entry);
+        }
+        entry.reading = reading;
+        entry.instance_handle = instance_handle;
+    }
+
+    // Calls function(const Temperature&, const dds::core::InstanceHandle&)
+    // once for each sensor with a pending reading, in the order the sensors
+    // were first updated
+    template <typename Function>
+    void process_pending(Function function)
+    {
+        for (Entry *entry : pending_entries) {
+            function(entry->reading, entry->instance_handle);
+            entry->pending = false;
+            processed_count++;
+        }
+        pending_entries.clear();
+    }
+
+    uint64_t received() const
+    {
+        return received_count;
+    }
+
+    uint64_t superseded() const
+    {
+        return superseded_count;
+    }
+
+    uint64_t processed() const
+    {
+        return processed_count;
+    }
+
+private:
+    struct Entry {
+        Entry() : pending(false)
+        {
+        }
+
+        Temperature reading;
+        dds::core::InstanceHandle instance_handle;
+        bool pending;
+    };
+
+    // One entry per sensor. Entries are reused, so updating a known sensor
+    // does not allocate.
+    std::unordered_map<std::string, Entry> entries;
+    std::vector<Entry *> pending_entries;
+    uint64_t received_count;
+    uint64_t superseded_count;
+    uint64_t processed_count;
+};
+
+#endif  // LATEST_VALUE_TABLE_HPP
@@ -0,0 +1,226 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rti/config/Logger.hpp>  // for logging
+
+#include "chocolate_factory.hpp"
+#include "chocolate_factory_format.hpp"
+#include "application.hpp"  // Argument parsing and logging
+#include "benchmark.hpp"  // Stopwatch and result printing
+
+using namespace application;
+
+// Logging benchmark:
+// Threads log the messages of the data paths of the applications, with 1 and
+// 4 threads:
+// 1) Before: written with std::endl under a lock, as std::cout does
+// 2) After: log_message(), with the AsyncLog writer thread
+//
+// For each, two results:
+// - data path: the time the threads spend logging, added up: the cost of a
+//   message to a handler
+// - written: the wall-clock time until every message is written
+//
+// The asynchronous messages are logged in bursts that fit in the ring of
+// each thread, and each thread waits for the writer between bursts, so that
+// no message is dropped. The waits are not part of the data path time.
+// The messages are written to a file, so that the terminal does not limit
+// the rate.
+//
+// -s, --sample-count sets how many messages each thread logs.
+
+const unsigned int DEFAULT_SAMPLE_COUNT = 100000;
+
+const char *const LOG_FILE_NAME = "logging_benchmark.log";
+
+// The message of process_lot(), or that of monitor_lot_state()
+enum class MessageKind {
+    lot_id,
+    lot_state
+};
+
+const std::string LABEL = "Lot Update from SUGAR_CONTROLLER";
+
+ChocolateLotState lot_state(unsigned int lot_id)
+{
+    ChocolateLotState state;
+    state.lot_id = lot_id;
+    state.station = StationKind::SUGAR_CONTROLLER;
+    state.next_station = StationKind::MILK_CONTROLLER;
+    state.lot_status = LotStatusKind::COMPLETED;
+    return state;
+}
+
+// Runs function(thread_index) in thread_count threads, until they all finish
+template <typename Function>
+void run_threads(unsigned int thread_count, Function function)
+{
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < thread_count; i++) {
+        threads.push_back(std::thread(function, i));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void print_results(
+        const std::string& mode,
+        MessageKind kind,
+        unsigned int thread_count,
+        unsigned int sample_count,
+        const std::vector<double>& data_path_seconds,
+        double written_seconds)
+{
+    std::string name = mode
+            + (kind == MessageKind::lot_id ? ", lot ID, " : ", lot state, ")
+            + std::to_string(thread_count) + " thread"
+            + (thread_count > 1 ? "s" : "");
+    unsigned long long message_count =
+            static_cast<unsigned long long>(thread_count) * sample_count;
+    double data_path_total = 0;
+    for (double seconds : data_path_seconds) {
+        data_path_total += seconds;
+    }
+    benchmark::print_result(
+            name + ", data path",
+            message_count,
+            data_path_total);
+    benchmark::print_result(name + ", written", message_count, written_seconds);
+}
+
+void benchmark_stream(
+        MessageKind kind,
+        unsigned int thread_count,
+        unsigned int sample_count)
+{
+    std::ofstream file(LOG_FILE_NAME);
+    std::mutex file_mutex;
+    std::vector<double> data_path_seconds(thread_count);
+    benchmark::Stopwatch written_stopwatch;
+    run_threads(thread_count, [&](unsigned int index) {
+        benchmark::Stopwatch stopwatch;
+        for (unsigned int i = 0; i < sample_count && !shutdown_requested;
+             i++) {
+            std::lock_guard<std::mutex> lock(file_mutex);
+            if (kind == MessageKind::lot_id) {
+                file << "Processing lot #" << i << std::endl;
+            } else {
+                file << "Received " << LABEL << ":" << std::endl;
+                file << lot_state(i) << std::endl;
+            }
+        }
+        data_path_seconds[index] = stopwatch.elapsed_seconds();
+    });
+    print_results(
+            "std::endl",
+            kind,
+            thread_count,
+            sample_count,
+            data_path_seconds,
+            written_stopwatch.elapsed_seconds());
+}
+
+void benchmark_async_log(
+        MessageKind kind,
+        unsigned int thread_count,
+        unsigned int sample_count)
+{
+    std::ofstream file(LOG_FILE_NAME);
+    uint64_t dropped_before = AsyncLog::instance().dropped();
+    std::vector<double> data_path_seconds(thread_count);
+    benchmark::Stopwatch written_stopwatch;
+    {
+        LogWriter log_writer(LogLevel::info, file);
+        run_threads(thread_count, [&](unsigned int index) {
+            benchmark::Stopwatch stopwatch;
+            for (unsigned int first = 0;
+                 first < sample_count && !shutdown_requested;
+                 first += AsyncLog::RING_CAPACITY) {
+                unsigned int last = static_cast<unsigned int>(std::min<size_t>(
+                        sample_count,
+                        first + AsyncLog::RING_CAPACITY));
+                stopwatch.restart();
+                for (unsigned int i = first; i < last; i++) {
+                    if (kind == MessageKind::lot_id) {
+                        log_message(LogLevel::info, "Processing lot #", i);
+                    } else {
+                        log_message(
+                                LogLevel::info,
+                                "Received ",
+                                LABEL,
+                                ":\n",
+                                formatted(lot_state(i)));
+                    }
+                }
+                data_path_seconds[index] += stopwatch.elapsed_seconds();
+                AsyncLog::instance().flush();
+            }
+        });
+    }
+    print_results(
+            "Async log",
+            kind,
+            thread_count,
+            sample_count,
+            data_path_seconds,
+            written_stopwatch.elapsed_seconds());
+    uint64_t dropped = AsyncLog::instance().dropped() - dropped_before;
+    if (dropped > 0) {
+        std::cout << "    dropped: " << dropped << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    // The sample count defaults to infinite, use a finite number of messages
+    unsigned int sample_count = arguments.sample_count
+                    == (std::numeric_limits<unsigned int>::max)()
+            ? DEFAULT_SAMPLE_COUNT
+            : arguments.sample_count;
+
+    std::cout << "Benchmarking " << sample_count
+              << " log messages per thread, written to " << LOG_FILE_NAME
+              << std::endl;
+    const MessageKind kinds[] = { MessageKind::lot_id, MessageKind::lot_state };
+    const unsigned int thread_counts[] = { 1, 4 };
+    for (MessageKind kind : kinds) {
+        for (unsigned int thread_count : thread_counts) {
+            benchmark_stream(kind, thread_count, sample_count);
+            benchmark_async_log(kind, thread_count, sample_count);
+        }
+    }
+
+    std::remove(LOG_FILE_NAME);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,337 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef LOT_SNAPSHOT_HPP
+#define LOT_SNAPSHOT_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "chocolate_factory.hpp"
+#include "lot_table.hpp"
+
+// Checkpoints of a LotTable in a memory-mapped file, so that a restarted
+// application knows the lots in flight before the durable history of the
+// lot states is received again.
+//
+// The file has two slots. A checkpoint overwrites the older one, and a
+// sequence number and a checksum of the whole slot tell which one is
+// complete and newest. If the application stops in the middle of a
+// checkpoint, the previous checkpoint is loaded. Writing a checkpoint takes
+// 8 bytes per lot; the operating system writes the pages to disk in the
+// background.
+//
+// Memory-mapped files are only supported on POSIX systems.
+class LotSnapshot {
+public:
+    // Opens the file, or creates it for capacity lots. A file for another
+    // capacity is replaced. Throws std::runtime_error on failure.
+    LotSnapshot(const std::string& path, size_t capacity)
+            : capacity(capacity),
+              file_size(size_for(capacity)),
+              data(nullptr),
+              next_sequence(1),
+              next_slot(0)
+    {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            throw std::runtime_error(error_message("open", path));
+        }
+        struct stat file_stat;
+        bool reuse = ::fstat(fd, &file_stat) == 0
+                && static_cast<size_t>(file_stat.st_size) == file_size;
+        if (!reuse
+            && (::ftruncate(fd, 0) != 0
+                || ::ftruncate(fd, static_cast<off_t>(file_size)) != 0)) {
+            ::close(fd);
+            throw std::runtime_error(error_message("ftruncate", path));
+        }
+        void *address = ::mmap(
+                nullptr,
+                file_size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                fd,
+                0);
+        // The mapping stays valid after the file is closed
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            throw std::runtime_error(error_message("mmap", path));
+        }
+        data = static_cast<unsigned char *>(address);
+
+        FileHeader *header = file_header(data);
+        if (!reuse || !valid_header(*header, file_size)) {
+            std::memset(data, 0, file_size);
+            std::memcpy(header->magic, magic(), sizeof(header->magic));
+            header->capacity = static_cast<uint32_t>(capacity);
+        }
+        // Continue the sequence of the existing checkpoints, and overwrite
+        // the older one first
+        int newest = newest_slot(data);
+        if (newest >= 0) {
+            next_sequence = slot_header(data, newest)->sequence + 1;
+            next_slot = 1 - newest;
+        }
+#else
+        throw std::runtime_error(
+                "Lot snapshots need memory-mapped files, which are not "
+                "supported on this platform: " + path);
+#endif
+    }
+
+    ~LotSnapshot()
+    {
+#ifndef _WIN32
+        if (data != nullptr) {
+            ::munmap(data, file_size);
+        }
+#endif
+    }
+
+    // Writes the lots of the table to the older slot, as many as fit
+    void checkpoint(const LotTable& lot_table)
+    {
+        SlotHeader *slot = slot_header(data, next_slot);
+        Entry *entries = slot_entries(slot);
+        // A stop before the checkpoint is complete leaves the slot invalid
+        slot->sequence = 0;
+        uint32_t count = 0;
+        for (size_t status = 0; status < LotTable::STATUS_COUNT; status++) {
+            lot_table.for_each_with_status(
+                    static_cast<LotStatusKind>(status),
+                    [&](const LotTable::LotRecord& lot) {
+                        if (count < capacity) {
+                            entries[count++] = entry_for(lot);
+                        }
+                    });
+        }
+        slot->count = count;
+        slot->checksum = checksum(next_sequence, count, entries);
+        slot->sequence = next_sequence++;
+#ifndef _WIN32
+        // Schedule the write to disk without waiting for it
+        ::msync(data, file_size, MS_ASYNC);
+#endif
+        next_slot = 1 - next_slot;
+    }
+
+    // Calls function(const ChocolateLotState&) for each lot of the newest
+    // complete checkpoint in a file. Returns false if the file does not
+    // exist or has no complete checkpoint.
+    template <typename Function>
+    static bool load(const std::string& path, Function function)
+    {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0
+            || static_cast<size_t>(file_stat.st_size) < sizeof(FileHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size_t size = static_cast<size_t>(file_stat.st_size);
+        void *address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        const unsigned char *file = static_cast<unsigned char *>(address);
+
+        int newest = valid_header(*file_header(file), size)
+                ? newest_slot(file)
+                : -1;
+        if (newest >= 0) {
+            const SlotHeader *slot = slot_header(file, newest);
+            const Entry *entries = slot_entries(slot);
+            ChocolateLotState state;
+            for (uint32_t i = 0; i < slot->count; i++) {
+                state.lot_id = entries[i].lot_id;
+                state.station = static_cast<StationKind>(entries[i].station);
+                state.next_station =
+                        static_cast<StationKind>(entries[i].next_station);
+                state.lot_status =
+                        static_cast<LotStatusKind>(entries[i].lot_status);
+                function(state);
+            }
+        }
+        ::munmap(address, size);
+        return newest >= 0;
+#else
+        (void) path;
+        (void) function;
+        return false;
+#endif
+    }
+
+private:
+    struct FileHeader {
+        char magic[8];
+        uint32_t capacity;
+        uint32_t reserved;
+    };
+
+    struct SlotHeader {
+        // 0 while the slot is being written
+        uint64_t sequence;
+        uint32_t count;
+        uint32_t checksum;
+    };
+
+    struct Entry {
+        uint32_t lot_id;
+        uint8_t station;
+        uint8_t next_station;
+        uint8_t lot_status;
+        uint8_t reserved;
+    };
+
+    // Identifies the file format
+    static const char *magic()
+    {
+        return "LOTSNAP2";
+    }
+
+    static size_t slot_size(size_t capacity)
+    {
+        return sizeof(SlotHeader) + capacity * sizeof(Entry);
+    }
+
+    static size_t size_for(size_t capacity)
+    {
+        return sizeof(FileHeader) + 2 * slot_size(capacity);
+    }
+
+    static FileHeader *file_header(unsigned char *file)
+    {
+        return reinterpret_cast<FileHeader *>(file);
+    }
+
+    static const FileHeader *file_header(const unsigned char *file)
+    {
+        return reinterpret_cast<const FileHeader *>(file);
+    }
+
+    static SlotHeader *slot_header(unsigned char *file, int slot)
+    {
+        return reinterpret_cast<SlotHeader *>(
+                file + sizeof(FileHeader)
+                + slot * slot_size(file_header(file)->capacity));
+    }
+
+    static const SlotHeader *slot_header(const unsigned char *file, int slot)
+    {
+        return reinterpret_cast<const SlotHeader *>(
+                file + sizeof(FileHeader)
+                + slot * slot_size(file_header(file)->capacity));
+    }
+
+    static Entry *slot_entries(SlotHeader *slot)
+    {
+        return reinterpret_cast<Entry *>(slot + 1);
+    }
+
+    static const Entry *slot_entries(const SlotHeader *slot)
+    {
+        return reinterpret_cast<const Entry *>(slot + 1);
+    }
+
+    static bool valid_header(const FileHeader& header, size_t size)
+    {
+        return std::memcmp(header.magic, magic(), sizeof(header.magic)) == 0
+                && size == size_for(header.capacity);
+    }
+
+    // Returns the complete slot with the highest sequence, or -1
+    static int newest_slot(const unsigned char *file)
+    {
+        int newest = -1;
+        uint64_t newest_sequence = 0;
+        for (int slot = 0; slot < 2; slot++) {
+            const SlotHeader *header = slot_header(file, slot);
+            if (header->sequence > newest_sequence
+                && header->count <= file_header(file)->capacity
+                && header->checksum
+                        == checksum(
+                                header->sequence,
+                                header->count,
+                                slot_entries(header))) {
+                newest = slot;
+                newest_sequence = header->sequence;
+            }
+        }
+        return newest;
+    }
+
+    static Entry entry_for(const LotTable::LotRecord& lot)
+    {
+        Entry entry;
+        entry.lot_id = lot.lot_id;
+        entry.station = static_cast<uint8_t>(lot.station);
+        entry.next_station = static_cast<uint8_t>(lot.next_station);
+        entry.lot_status = static_cast<uint8_t>(lot.lot_status);
+        entry.reserved = 0;
+        return entry;
+    }
+
+    // FNV-1a of the sequence, the count and the entries of a slot
+    static uint32_t checksum(
+            uint64_t sequence,
+            uint32_t count,
+            const Entry *entries)
+    {
+        uint32_t hash = 2166136261u;
+        for (int shift = 0; shift < 64; shift += 8) {
+            hash = (hash ^ static_cast<uint8_t>(sequence >> shift))
+                    * 16777619u;
+        }
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash = (hash ^ static_cast<uint8_t>(count >> shift)) * 16777619u;
+        }
+        const unsigned char *bytes =
+                reinterpret_cast<const unsigned char *>(entries);
+        for (size_t i = 0; i < count * sizeof(Entry); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    static std::string error_message(
+            const std::string& operation,
+            const std::string& path)
+    {
+        return "Lot snapshot " + path + ": " + operation + " failed: "
+                + std::strerror(errno);
+    }
+
+    size_t capacity;
+    size_t file_size;
+    unsigned char *data;
+    uint64_t next_sequence;
+    int next_slot;
+};
+
+#endif  // LOT_SNAPSHOT_HPP
@@ -0,0 +1,303 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef LOT_TABLE_HPP
+#define LOT_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "chocolate_factory.hpp"
+
+// Current state of every chocolate lot, with indexes by station and by
+// status. Updating, removing and finding a lot, and counting the lots of a
+// station or status, take constant time.
+//
+// The capacity is fixed when the table is created, and nothing is allocated
+// afterwards. Memory per lot of capacity:
+// - 32 bytes for its LotRecord
+// - 8 to 16 bytes for the lot_id hash index: 2 to 4 slots of 4 bytes, the
+//   capacity doubled and rounded up to a power of two
+class LotTable {
+public:
+    static const size_t STATION_COUNT =
+            static_cast<size_t>(StationKind::TEMPERING_CONTROLLER) + 1;
+    static const size_t STATUS_COUNT =
+            static_cast<size_t>(LotStatusKind::COMPLETED) + 1;
+
+    // State of a lot. The links are the indexes of the previous and next
+    // lots at the same station and with the same status.
+    struct LotRecord {
+        uint32_t lot_id;
+        StationKind station;
+        StationKind next_station;
+        LotStatusKind lot_status;
+        uint32_t station_prev;
+        uint32_t station_next;
+        uint32_t status_prev;
+        uint32_t status_next;
+    };
+
+    explicit LotTable(size_t capacity)
+            : records(capacity),
+              slots(slot_count_for(capacity), EMPTY),
+              slot_mask(slots.size() - 1),
+              hash_shift(32),
+              free_head(NONE),
+              used_count(0)
+    {
+        for (size_t count = slots.size(); count > 1; count /= 2) {
+            hash_shift--;
+        }
+
+        // Every record starts in the free list, linked by station_next
+        for (size_t i = 0; i < capacity; i++) {
+            records[i].station_next =
+                    i + 1 < capacity ? static_cast<uint32_t>(i + 1) : NONE;
+        }
+        if (capacity > 0) {
+            free_head = 0;
+        }
+    }
+
+    // The station a lot is at: the station processing it, or the station
+    // it waits for
+    static StationKind location(const LotRecord& lot)
+    {
+        return lot.lot_status == LotStatusKind::PROCESSING ? lot.station
+                                                           : lot.next_station;
+    }
+
+    // Adds a lot, or updates its state and moves it between the indexes.
+    // Returns false when the lot is new and the table is full.
+    bool update(const ChocolateLotState& state)
+    {
+        size_t slot = find_slot(state.lot_id);
+        uint32_t index = slots[slot];
+        if (index == EMPTY) {
+            if (free_head == NONE) {
+                return false;
+            }
+            index = free_head;
+            free_head = records[index].station_next;
+            slots[slot] = index;
+            used_count++;
+        } else {
+            unlink(index);
+        }
+
+        LotRecord& lot = records[index];
+        lot.lot_id = state.lot_id;
+        lot.station = state.station;
+        lot.next_station = state.next_station;
+        lot.lot_status = state.lot_status;
+        link(index);
+        return true;
+    }
+
+    // Removes a lot, for example when its instance is disposed. Returns
+    // false if the lot is not in the table.
+    bool remove(uint32_t lot_id)
+    {
+        size_t slot = find_slot(lot_id);
+        uint32_t index = slots[slot];
+        if (index == EMPTY) {
+            return false;
+        }
+        unlink(index);
+        records[index].station_next = free_head;
+        free_head = index;
+        used_count--;
+        erase_slot(slot);
+        return true;
+    }
+
+    // Returns the lot, or nullptr if it is not in the table
+    const LotRecord *find(uint32_t lot_id) const
+    {
+        uint32_t index = slots[find_slot(lot_id)];
+        return index == EMPTY ? nullptr : &records[index];
+    }
+
+    size_t count_at_station(StationKind station) const
+    {
+        return station_lists[station_index(station)].count;
+    }
+
+    size_t count_with_status(LotStatusKind status) const
+    {
+        return status_lists[status_index(status)].count;
+    }
+
+    // Calls function(const LotRecord&) for each lot at a station
+    template <typename Function>
+    void for_each_at_station(StationKind station, Function function) const
+    {
+        for (uint32_t index = station_lists[station_index(station)].head;
+             index != NONE;
+             index = records[index].station_next) {
+            function(records[index]);
+        }
+    }
+
+    // Calls function(const LotRecord&) for each lot with a status
+    template <typename Function>
+    void for_each_with_status(LotStatusKind status, Function function) const
+    {
+        for (uint32_t index = status_lists[status_index(status)].head;
+             index != NONE;
+             index = records[index].status_next) {
+            function(records[index]);
+        }
+    }
+
+    size_t size() const
+    {
+        return used_count;
+    }
+
+    size_t capacity() const
+    {
+        return records.size();
+    }
+
+private:
+    // End of a list, and empty slot of the index
+    enum : uint32_t { NONE = 0xffffffff, EMPTY = NONE };
+
+    struct List {
+        List() : head(NONE), count(0)
+        {
+        }
+
+        uint32_t head;
+        size_t count;
+    };
+
+    // Keeps the load factor of the index at 1/2 or less
+    static size_t slot_count_for(size_t capacity)
+    {
+        size_t count = 2;
+        while (count < 2 * capacity) {
+            count *= 2;
+        }
+        return count;
+    }
+
+    static size_t station_index(StationKind station)
+    {
+        size_t index = static_cast<size_t>(station);
+        return index < STATION_COUNT ? index : 0;
+    }
+
+    static size_t status_index(LotStatusKind status)
+    {
+        size_t index = static_cast<size_t>(status);
+        return index < STATUS_COUNT ? index : 0;
+    }
+
+    size_t home_slot(uint32_t lot_id) const
+    {
+        // Fibonacci hashing: spreads consecutive lot IDs over the slots
+        return static_cast<uint32_t>(lot_id * 2654435769u) >> hash_shift;
+    }
+
+    // Returns the slot of lot_id, or the empty slot where it would be added
+    size_t find_slot(uint32_t lot_id) const
+    {
+        size_t slot = home_slot(lot_id);
+        while (slots[slot] != EMPTY && records[slots[slot]].lot_id != lot_id) {
+            slot = (slot + 1) & slot_mask;
+        }
+        return slot;
+    }
+
+    // Empties a slot, and moves back the lots after it that would no longer
+    // be found by linear probing. The index never needs tombstones.
+    void erase_slot(size_t slot)
+    {
+        size_t next = (slot + 1) & slot_mask;
+        while (slots[next] != EMPTY) {
+            size_t home = home_slot(records[slots[next]].lot_id);
+            // Move the lot if its home slot is not between slot and next
+            if (((next - home) & slot_mask) >= ((next - slot) & slot_mask)) {
+                slots[slot] = slots[next];
+                slot = next;
+            }
+            next = (next + 1) & slot_mask;
+        }
+        slots[slot] = EMPTY;
+    }
+
+    void link(uint32_t index)
+    {
+        LotRecord& lot = records[index];
+        List& station_list = station_lists[station_index(location(lot))];
+        lot.station_prev = NONE;
+        lot.station_next = station_list.head;
+        if (station_list.head != NONE) {
+            records[station_list.head].station_prev = index;
+        }
+        station_list.head = index;
+        station_list.count++;
+
+        List& status_list = status_lists[status_index(lot.lot_status)];
+        lot.status_prev = NONE;
+        lot.status_next = status_list.head;
+        if (status_list.head != NONE) {
+            records[status_list.head].status_prev = index;
+        }
+        status_list.head = index;
+        status_list.count++;
+    }
+
+    void unlink(uint32_t index)
+    {
+        LotRecord& lot = records[index];
+        List& station_list = station_lists[station_index(location(lot))];
+        if (lot.station_prev != NONE) {
+            records[lot.station_prev].station_next = lot.station_next;
+        } else {
+            station_list.head = lot.station_next;
+        }
+        if (lot.station_next != NONE) {
+            records[lot.station_next].station_prev = lot.station_prev;
+        }
+        station_list.count--;
+
+        List& status_list = status_lists[status_index(lot.lot_status)];
+        if (lot.status_prev != NONE) {
+            records[lot.status_prev].status_next = lot.status_next;
+        } else {
+            status_list.head = lot.status_next;
+        }
+        if (lot.status_next != NONE) {
+            records[lot.status_next].status_prev = lot.status_prev;
+        }
+        status_list.count--;
+    }
+
+    std::vector<LotRecord> records;
+    // Index of the record of each lot_id, by open addressing
+    std::vector<uint32_t> slots;
+    size_t slot_mask;
+    // 32 minus the number of bits of a slot number
+    unsigned int hash_shift;
+    // Unused records, linked by station_next
+    uint32_t free_head;
+    size_t used_count;
+    List station_lists[STATION_COUNT];
+    List status_lists[STATUS_COUNT];
+};
+
+#endif  // LOT_TABLE_HPP
@@ -10,8 +10,16 @@
  * to use the software.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include <dds/pub/ddspub.hpp>
 #include <dds/sub/ddssub.hpp>
@@ -21,58 +29,253 @@
 
 #include "chocolate_factory.hpp"
 #include "application.hpp"  // Argument parsing
+#include "catch_up_progress.hpp"  // Late-joiner progress
+#include "command_reader.hpp"  // Commands from the standard input
+#include "chocolate_factory_format.hpp"  // Allocation-free sample text
+#include "anomaly_detector.hpp"  // Temperature anomalies per sensor
+#include "equality_index_filter.hpp"  // Indexed next_station filter
+#include "factory_dashboard.hpp"  // Terminal dashboard
+#include "filter_parameter_update.hpp"  // Runtime filter parameters
+#include "filter_statistics.hpp"  // Content filter statistics
+#include "instance_key_cache.hpp"  // lot_id of each lot instance
+#include "instance_statistics.hpp"  // Live and purged instances
+#include "latest_value_table.hpp"  // Coalescing of temperature readings
+#include "lot_snapshot.hpp"  // Lot table checkpoints
+#include "lot_table.hpp"  // Current state of every lot
+#include "pipeline_kpis.hpp"  // Station KPIs
+#include "rolling_quantiles.hpp"  // Temperature quantiles per sensor
+#include "statistics_period.hpp"  // Periodic tasks
+#include "temperature_range_filter.hpp"  // Compiled temperature filter
+#include "temperature_scan.hpp"  // Vectorized out-of-range scan
 
 using namespace application;
 
+// Temperatures are only an error if below 30 or over 32 degrees Fahrenheit
+const int32_t TEMPERATURE_LOW = 30;
+const int32_t TEMPERATURE_HIGH = 32;
+
+// Lots tracked by the lot table besides the bulk lots. Lot states from
+// other applications beyond the capacity are printed but not tracked.
+const size_t LOT_TABLE_SPARE_CAPACITY = 1024;
+
+// Seconds between checkpoints of the lot table, with -m, --snapshot
+const unsigned int SNAPSHOT_PERIOD_SEC = 1;
+
+// Sliding window of the station KPIs, published every second
+const unsigned int KPI_WINDOW_SEC = 60;
+
+// Rolling window of the temperature quantiles of each sensor
+const unsigned int QUANTILE_WINDOW_SEC = 60;
+
+// Quantiles of the temperature readings of each sensor, by instance
+typedef RollingQuantiles<dds::core::InstanceHandle> TemperatureQuantiles;
+
+// Baseline of the temperature readings of each sensor, by instance
+typedef AnomalyDetector<dds::core::InstanceHandle> TemperatureAnomalyDetector;
+
+// Catching up with the durable history of the lot states ends when the lot
+// state DataReader has received the historical data of its matched
+// DataWriters, checked every HISTORICAL_DATA_POLL_PERIOD. As a fallback, it
+// ends when no lot state has arrived for CATCH_UP_TIMEOUT.
+const std::chrono::milliseconds HISTORICAL_DATA_POLL_PERIOD(100);
+const std::chrono::seconds CATCH_UP_TIMEOUT(5);
+
+// The dashboard shows the lots that have been at their station this long
+const std::chrono::seconds STUCK_LOT_THRESHOLD(60);
+
+// Lots known to the monitoring application. Only the WaitSet thread uses it.
+struct LotTracking {
+    explicit LotTracking(size_t capacity)
+            : table(capacity),
+              kpis(KPI_WINDOW_SEC),
+              catch_up(CATCH_UP_TIMEOUT),
+              print_updates(true),
+              ended_instances(0)
+    {
+    }
+
+    LotTable table;
+    PipelineKpis kpis;
+    // lot_id of each lot instance, for the disposed lots
+    InstanceKeyCache<uint32_t> lot_ids;
+    // Lots restored from the snapshot that the history has not confirmed
+    std::unordered_set<uint32_t> restored_lots;
+    CatchUpProgress catch_up;
+    // False when the dashboard shows the lots instead
+    bool print_updates;
+    // Lot instances disposed, or left without writers, so far: the
+    // DataReader purges them
+    uint64_t ended_instances;
+};
+
+// Name of the ContentFilteredTopic of temperatures out of range. Its
+// parameters are changed with the "temperature" command.
+const std::string TEMPERATURE_FILTER_NAME = "FilteredTemperature";
+
+// Starts bulk_lots lots at once, as happens when a shift starts. With the
+// asynchronous ChocolateLotStateAsyncProfile, write() only queues the samples
+// and the flow controller spreads them over time.
+void publish_bulk_lots(
+        dds::pub::DataWriter<ChocolateLotState>& lot_state_writer,
+        unsigned int bulk_lots,
+        bool print_updates,
+        std::atomic<uint64_t>& lots_started)
+{
+    ChocolateLotState sample;
+    sample.lot_status = LotStatusKind::WAITING;
+    sample.next_station = StationKind::COCOA_BUTTER_CONTROLLER;
+    for (unsigned int count = 0; !shutdown_requested && count < bulk_lots;
+         count++) {
+        sample.lot_id = count;
+        dds::core::InstanceHandle instance_handle =
+                lot_state_writer.register_instance(sample);
+        lot_state_writer.write(sample, instance_handle);
+        // The lot is handed over to the first station
+        lot_state_writer.unregister_instance(instance_handle);
+        lots_started++;
+    }
+    if (print_updates) {
+        std::cout << "Started " << bulk_lots << " lots" << std::endl;
+    }
+}
+
+// Starts the lots. lots_started counts the lot instances unregistered, which
+// the DataWriter purges.
 void publish_start_lot(
         dds::pub::DataWriter<ChocolateLotState> lot_state_writer,
-        unsigned int lots_to_process)
+        unsigned int lots_to_process,
+        unsigned int bulk_lots,
+        bool print_updates,
+        std::atomic<uint64_t>& lots_started)
 {
+    publish_bulk_lots(
+            lot_state_writer,
+            bulk_lots,
+            print_updates,
+            lots_started);
+
     ChocolateLotState sample;
     for (unsigned int count = 0; !shutdown_requested && count < lots_to_process;
          count++) {
         // Set the values for a chocolate lot that is going to be sent to wait
-        // at the tempering station
-        sample.lot_id = count % 100;
+        // at the tempering station. Lot IDs after the bulk lots.
+        sample.lot_id = bulk_lots + count % 100;
         sample.lot_status = LotStatusKind::WAITING;
         sample.next_station = StationKind::COCOA_BUTTER_CONTROLLER;
 
-        std::cout << std::endl << "Starting lot: " << std::endl;
-        std::cout << "[lot_id: " << sample.lot_id
-                  << " next_station: " << sample.next_station << "]"
-                  << std::endl;
+        if (print_updates) {
+            log_message(
+                    LogLevel::info,
+                    "\nStarting lot: \n[lot_id: ",
+                    sample.lot_id,
+                    " next_station: ",
+                    station_kind_name(sample.next_station),
+                    "]");
+        }
 
         // Send an update to station that there is a lot waiting for tempering
-        lot_state_writer.write(sample);
+        dds::core::InstanceHandle instance_handle =
+                lot_state_writer.register_instance(sample);
+        lot_state_writer.write(sample, instance_handle);
+
+        // The lot is handed over to the first station: unregister it, so
+        // that the DataWriter does not keep every lot it has started
+        lot_state_writer.unregister_instance(instance_handle);
+        lots_started++;
 
         rti::util::sleep(dds::core::Duration(30));
     }
 }
 
-unsigned int monitor_lot_state(dds::sub::DataReader<ChocolateLotState>& reader)
+// Takes the samples selected by one of the conditions of the lot state
+// DataReader, and updates the lot table and the station KPIs. A lot restored
+// from the snapshot is confirmed by its first update. The samples are only
+// printed after catching up with the durable history, and without the
+// dashboard, with the label and the name of the station they are from, if
+// any. Returns the number of valid samples.
+unsigned int monitor_lot_state(
+        dds::sub::DataReader<ChocolateLotState>& reader,
+        const dds::sub::cond::ReadCondition& condition,
+        const char *label,
+        LotTracking& lots,
+        const char *station_name = "")
 {
-    // Take all samples.  Samples are loaned to application, loan is
-    // returned when LoanedSamples destructor called.
+    // Take the samples of the condition.  Samples are loaned to application,
+    // loan is returned when LoanedSamples destructor called.
     unsigned int samples_read = 0;
-    dds::sub::LoanedSamples<ChocolateLotState> samples = reader.take();
+    dds::sub::LoanedSamples<ChocolateLotState> samples =
+            reader.select().condition(condition).take();
+    PipelineKpis::clock::time_point now = PipelineKpis::clock::now();
+    lots.catch_up.received(samples.length(), now);
+    bool print = lots.print_updates && !lots.catch_up.active();
 
     // Receive updates from stations about the state of current lots
     for (const auto& sample : samples) {
-        std::cout << "Received Lot Update:" << std::endl;
         if (sample.info().valid()) {
-            std::cout << sample.data() << std::endl;
+            if (print) {
+                log_message(
+                        LogLevel::info,
+                        "Received ",
+                        label,
+                        station_name,
+                        ":\n",
+                        formatted(sample.data()));
+            }
             samples_read++;
+            lots.lot_ids.insert(
+                    sample.info().instance_handle(),
+                    sample.data().lot_id);
+            lots.restored_lots.erase(sample.data().lot_id);
+            // The KPIs compare the update with the state in the table
+            lots.kpis.update(
+                    lots.table.find(sample.data().lot_id),
+                    sample.data(),
+                    now);
+            if (!lots.table.update(sample.data())) {
+                log_message(
+                        LogLevel::warning,
+                        "Lot table full, not tracking lot ",
+                        sample.data().lot_id);
+            }
         } else {
             // Detect that a lot is complete by checking for
             // the disposed state.
             if (sample.info().state().instance_state()
                     == dds::sub::status::InstanceState::not_alive_disposed()) {
-                ChocolateLotState key_holder;
-                // Fills in only the key field values associated with the
-                // instance
-                reader.key_value(key_holder, sample.info().instance_handle());
-                std::cout << "[lot_id: " << key_holder.lot_id
-                            << " is completed]" << std::endl;
+                // The lot_id comes from the cache, or from the DataReader
+                // for a lot without valid samples
+                uint32_t lot_id = 0;
+                if (!lots.lot_ids.take(
+                            sample.info().instance_handle(),
+                            lot_id)) {
+                    ChocolateLotState key_holder;
+                    // Fills in only the key field values associated with the
+                    // instance
+                    reader.key_value(
+                            key_holder,
+                            sample.info().instance_handle());
+                    lot_id = key_holder.lot_id;
+                }
+                if (print) {
+                    log_message(
+                            LogLevel::info,
+                            "Received ",
+                            label,
+                            station_name,
+                            ":\n[lot_id: ",
+                            lot_id,
+                            " is completed]");
+                }
+                lots.table.remove(lot_id);
+                lots.kpis.remove(lot_id);
+                lots.restored_lots.erase(lot_id);
+                lots.ended_instances++;
+            } else {
+                // No writers: the DataReader may purge the instance, and the
+                // lot may never be disposed. The entry is added again with
+                // its next valid sample.
+                lots.lot_ids.remove(sample.info().instance_handle());
+                lots.ended_instances++;
             }
         }
     }
@@ -80,35 +283,606 @@ unsigned int monitor_lot_state(dds::sub::DataReader<ChocolateLotState>& reader)
     return samples_read;
 }
 
+// Returns whether the DataReader has received the historical data of the
+// DataWriters it has matched, without waiting. The DataWriter of this
+// application matches at once and has no history to send, so a remote
+// DataWriter must be matched: until then, the history has not started to
+// arrive.
+bool historical_data_received(
+        dds::sub::DataReader<ChocolateLotState>& reader,
+        const dds::core::InstanceHandle& own_writer)
+{
+    std::vector<dds::core::InstanceHandle> writers =
+            dds::sub::matched_publications(reader);
+    if (std::none_of(
+                writers.begin(),
+                writers.end(),
+                [&own_writer](const dds::core::InstanceHandle& writer) {
+                    return writer != own_writer;
+                })) {
+        return false;
+    }
+    try {
+        reader.wait_for_historical_data(dds::core::Duration::zero());
+    } catch (const dds::core::TimeoutError&) {
+        return false;
+    }
+    return true;
+}
+
+// Prints how many lots are at each station and in each status
+void print_lot_table(const LotTable& lot_table, std::ostream& out)
+{
+    const StationKind stations[] = { StationKind::COCOA_BUTTER_CONTROLLER,
+                                     StationKind::SUGAR_CONTROLLER,
+                                     StationKind::MILK_CONTROLLER,
+                                     StationKind::VANILLA_CONTROLLER,
+                                     StationKind::TEMPERING_CONTROLLER };
+    out << "Lots tracked: " << lot_table.size() << " of "
+        << lot_table.capacity() << std::endl;
+    for (StationKind station : stations) {
+        out << "    at " << station_kind_name(station) << ": "
+            << lot_table.count_at_station(station) << std::endl;
+    }
+    out << "    waiting: "
+        << lot_table.count_with_status(LotStatusKind::WAITING)
+        << ", processing: "
+        << lot_table.count_with_status(LotStatusKind::PROCESSING)
+        << ", completed: "
+        << lot_table.count_with_status(LotStatusKind::COMPLETED)
+        << std::endl;
+}
+
+// Loads the lots of the last checkpoint into the lot table. They stay in
+// restored_lots until an update from the durable history confirms them. The
+// history is expected to have a sample per restored lot: those it does not
+// confirm are removed once caught up with it.
+void restore_lot_table(
+        const std::string& snapshot_file,
+        LotTracking& lots,
+        std::ostream& out)
+{
+    auto start_time = std::chrono::steady_clock::now();
+    bool restored = LotSnapshot::load(
+            snapshot_file,
+            [&lots](const ChocolateLotState& state) {
+                if (lots.table.update(state)) {
+                    lots.restored_lots.insert(state.lot_id);
+                }
+            });
+    if (!restored) {
+        out << "No lot table snapshot in " << snapshot_file << std::endl;
+        return;
+    }
+    out << "Restored " << lots.restored_lots.size() << " lots from "
+        << snapshot_file << " in "
+        << std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start_time)
+                   .count()
+        << " ms" << std::endl;
+    print_lot_table(lots.table, out);
+    lots.catch_up.expect(lots.restored_lots.size());
+}
+
+// Removes the restored lots that the durable history did not confirm, once
+// caught up with it. Not called when catching up timed out without history:
+// the lots are kept until the stations update them.
+void expire_restored_lots(LotTracking& lots, std::ostream& out)
+{
+    for (uint32_t lot_id : lots.restored_lots) {
+        out << "[lot_id: " << lot_id
+            << " from the snapshot is no longer in progress]" << std::endl;
+        lots.table.remove(lot_id);
+    }
+    lots.restored_lots.clear();
+}
+
+// Prints how often the lot_id of a completed lot was found in the cache
+void print_lot_id_cache_statistics(
+        const InstanceKeyCache<uint32_t>& lot_ids,
+        std::ostream& out)
+{
+    uint64_t lookups = lot_ids.hits() + lot_ids.misses();
+    out << "Lot ID cache: " << lot_ids.size()
+        << " lots, completions found: " << lot_ids.hits() << " of "
+        << lookups;
+    if (lookups > 0) {
+        out << " (" << 100.0 * lot_ids.hits() / lookups << "%)";
+    }
+    out << std::endl;
+}
+
+void print_station_kpi(const StationKpi& kpi, std::ostream& out)
+{
+    out << station_kind_name(kpi.station) << " (last " << kpi.window_sec
+        << " s): arrivals: " << kpi.arrivals
+        << ", completions: " << kpi.completions
+        << ", work in progress: " << kpi.work_in_progress
+        << ", throughput: " << kpi.throughput_per_sec << "/s"
+        << ", mean service: " << kpi.mean_service_sec << " s"
+        << ", mean time in station: " << kpi.mean_time_in_station_sec
+        << " s, utilization: " << kpi.utilization
+        << ", mean work in progress: " << kpi.mean_work_in_progress
+        << std::endl;
+}
+
+// Reports when a reading starts or ends an anomaly of its sensor: a spike or
+// a drift away from the baseline of its previous readings, on the dashboard
+// if there is one
+void detect_temperature_anomaly(
+        TemperatureAnomalyDetector& anomaly_detector,
+        const dds::core::InstanceHandle& instance_handle,
+        const Temperature& temperature,
+        FactoryDashboard *dashboard)
+{
+    double z_score = 0;
+    AnomalyEvent event = anomaly_detector.update(
+            instance_handle,
+            temperature.degrees,
+            z_score);
+    if (event != AnomalyEvent::none && dashboard != nullptr) {
+        dashboard->temperature_anomaly(
+                temperature,
+                event == AnomalyEvent::started);
+    } else if (event == AnomalyEvent::started) {
+        const EwmaDetector *baseline = anomaly_detector.find(instance_handle);
+        log_message(
+                LogLevel::warning,
+                "Temperature anomaly: ",
+                formatted(temperature),
+                " z-score: ",
+                z_score,
+                ", baseline: ",
+                baseline->baseline_mean(),
+                " +/- ",
+                baseline->baseline_stddev());
+    } else if (event == AnomalyEvent::ended) {
+        log_message(
+                LogLevel::info,
+                "Temperature back to baseline: ",
+                formatted(temperature));
+    }
+}
+
+// Adds a reading to the quantiles of its sensor and, with an anomaly
+// detector, compares it with the baseline of the sensor. With a dashboard,
+// the reading is counted on it.
+void analyze_temperature(
+        const dds::core::InstanceHandle& instance_handle,
+        const Temperature& temperature,
+        TemperatureQuantiles::clock::time_point now,
+        TemperatureQuantiles& quantiles,
+        TemperatureAnomalyDetector *anomaly_detector,
+        FactoryDashboard *dashboard)
+{
+    quantiles.add(
+            instance_handle,
+            temperature.sensor_id,
+            temperature.degrees,
+            now);
+    if (anomaly_detector != nullptr) {
+        detect_temperature_anomaly(
+                *anomaly_detector,
+                instance_handle,
+                temperature,
+                dashboard);
+    }
+    if (dashboard != nullptr) {
+        dashboard->temperature_received(
+                temperature.degrees,
+                temperature.degrees);
+    }
+}
+
+// Forgets a sensor that is gone
+void remove_temperature_sensor(
+        const dds::core::InstanceHandle& instance_handle,
+        TemperatureQuantiles& quantiles,
+        TemperatureAnomalyDetector *anomaly_detector)
+{
+    quantiles.remove(instance_handle);
+    if (anomaly_detector != nullptr) {
+        anomaly_detector->remove(instance_handle);
+    }
+}
+
+// Scans the degrees of a block of readings at once, and reports those out of
+// range. temperature_at(i) returns the reading of degrees[i].
+template <typename TemperatureAt>
+void report_out_of_range(
+        const int32_t *degrees,
+        size_t count,
+        const TemperatureRange& range,
+        temperature_scan::ScanStats& scan_stats,
+        TemperatureAt temperature_at,
+        FactoryDashboard *dashboard)
+{
+    uint64_t out_of_range = temperature_scan::scan_block(
+            degrees,
+            count,
+            range.low,
+            range.high,
+            scan_stats);
+    while (out_of_range != 0) {
+        unsigned int i = temperature_scan::lowest_bit_index(out_of_range);
+        out_of_range &= out_of_range - 1;
+        const Temperature& temperature = temperature_at(i);
+        if (dashboard != nullptr) {
+            dashboard->temperature_out_of_range(
+                    temperature.sensor_id,
+                    temperature.degrees,
+                    temperature.degrees);
+        } else {
+            log_message(
+                    LogLevel::warning,
+                    "Tempering temperature out of range: ",
+                    formatted(temperature));
+        }
+    }
+}
+
 // Add monitor_temperature function
-void monitor_temperature(dds::sub::DataReader<Temperature>& reader)
+void monitor_temperature(
+        dds::sub::DataReader<Temperature>& reader,
+        const TemperatureRange& range,
+        temperature_scan::ScanStats& scan_stats,
+        TemperatureQuantiles& quantiles,
+        TemperatureAnomalyDetector *anomaly_detector,
+        FactoryDashboard *dashboard)
 {
+    using temperature_scan::BLOCK_SIZE;
+
     // Take all samples.  Samples are loaned to application, loan is
     // returned when LoanedSamples destructor called.
     dds::sub::LoanedSamples<Temperature> samples = reader.take();
 
     // Receive updates from tempering station about chocolate temperature.
-    // Only an error if below 30 or over 32 degrees Fahrenheit.
+    // The degrees of each block of valid samples are scanned at once, and
+    // only the samples out of range are printed. The samples stay in the
+    // loan: only their degrees are gathered.
+    TemperatureQuantiles::clock::time_point now =
+            TemperatureQuantiles::clock::now();
+    int32_t degrees[BLOCK_SIZE];
+    uint32_t sample_indexes[BLOCK_SIZE];
+    uint32_t next_index = 0;
+    while (next_index < samples.length()) {
+        size_t count = 0;
+        for (; next_index < samples.length() && count < BLOCK_SIZE;
+             next_index++) {
+            const auto& sample = samples[next_index];
+            if (sample.info().valid()) {
+                degrees[count] = sample.data().degrees;
+                sample_indexes[count] = next_index;
+                count++;
+                analyze_temperature(
+                        sample.info().instance_handle(),
+                        sample.data(),
+                        now,
+                        quantiles,
+                        anomaly_detector,
+                        dashboard);
+            } else if (
+                    sample.info().state().instance_state()
+                    != dds::sub::status::InstanceState::alive()) {
+                remove_temperature_sensor(
+                        sample.info().instance_handle(),
+                        quantiles,
+                        anomaly_detector);
+            }
+        }
+
+        report_out_of_range(
+                degrees,
+                count,
+                range,
+                scan_stats,
+                [&samples, &sample_indexes](unsigned int i)
+                        -> const Temperature& {
+                    return samples[sample_indexes[i]].data();
+                },
+                dashboard);
+    }
+}
+
+void print_scan_statistics(const temperature_scan::ScanStats& scan_stats)
+{
+    if (scan_stats.count == 0) {
+        return;
+    }
+    std::cout << "Temperature readings scanned: " << scan_stats.count
+              << ", min: " << scan_stats.min_degrees
+              << ", max: " << scan_stats.max_degrees << ", mean: "
+              << static_cast<double>(scan_stats.sum_degrees) / scan_stats.count
+              << std::endl;
+}
+
+void print_temperature_quantiles(
+        TemperatureQuantiles& quantiles,
+        std::ostream& out)
+{
+    out << "Temperature quantiles (last " << quantiles.window() << " s):"
+        << std::endl;
+    quantiles.for_each(
+            TemperatureQuantiles::clock::now(),
+            [&out](const std::string& sensor_id,
+                   uint64_t count,
+                   int32_t p50,
+                   int32_t p95,
+                   int32_t p99) {
+                out << "    sensor " << sensor_id << ": readings: " << count
+                    << ", p50: " << p50 << ", p95: " << p95
+                    << ", p99: " << p99 << std::endl;
+            });
+}
+
+// Coalescing version of monitor_temperature: when several readings of a
+// sensor are waiting, only the newest one is analyzed and scanned
+void monitor_latest_temperature(
+        dds::sub::DataReader<Temperature>& reader,
+        LatestTemperatureTable& latest_temperatures,
+        const TemperatureRange& range,
+        temperature_scan::ScanStats& scan_stats,
+        TemperatureQuantiles& quantiles,
+        TemperatureAnomalyDetector *anomaly_detector,
+        FactoryDashboard *dashboard)
+{
+    using temperature_scan::BLOCK_SIZE;
+
+    std::vector<dds::core::InstanceHandle> gone_sensors;
+    dds::sub::LoanedSamples<Temperature> samples = reader.take();
     for (const auto& sample : samples) {
         if (sample.info().valid()) {
-            std::cout << "Tempering temperature out of range: " << sample.data()
-                      << std::endl;
-       }
+            latest_temperatures.update(
+                    sample.data(),
+                    sample.info().instance_handle());
+        } else if (
+                sample.info().state().instance_state()
+                != dds::sub::status::InstanceState::alive()) {
+            gone_sensors.push_back(sample.info().instance_handle());
+        }
+    }
+
+    // The newest readings are scanned in blocks, as in monitor_temperature
+    TemperatureQuantiles::clock::time_point now =
+            TemperatureQuantiles::clock::now();
+    int32_t degrees[BLOCK_SIZE];
+    const Temperature *block[BLOCK_SIZE];
+    size_t count = 0;
+    auto temperature_at = [&block](unsigned int i) -> const Temperature& {
+        return *block[i];
+    };
+    latest_temperatures.process_pending(
+            [&](const Temperature& temperature,
+                const dds::core::InstanceHandle& instance_handle) {
+                analyze_temperature(
+                        instance_handle,
+                        temperature,
+                        now,
+                        quantiles,
+                        anomaly_detector,
+                        dashboard);
+                degrees[count] = temperature.degrees;
+                block[count] = &temperature;
+                if (++count == BLOCK_SIZE) {
+                    report_out_of_range(
+                            degrees,
+                            count,
+                            range,
+                            scan_stats,
+                            temperature_at,
+                            dashboard);
+                    count = 0;
+                }
+            });
+    report_out_of_range(
+            degrees,
+            count,
+            range,
+            scan_stats,
+            temperature_at,
+            dashboard);
+
+    // After the readings they sent last
+    for (const dds::core::InstanceHandle& instance_handle : gone_sensors) {
+        remove_temperature_sensor(instance_handle, quantiles, anomaly_detector);
+    }
+}
+
+void print_coalescing_statistics(
+        CoalesceMode coalesce_mode,
+        dds::sub::DataReader<Temperature>& reader,
+        const LatestTemperatureTable& latest_temperatures)
+{
+    if (coalesce_mode == CoalesceMode::qos) {
+        // Samples replaced in the DataReader queue by KEEP_LAST history
+        std::cout << "Temperature readings superseded in DataReader: "
+                  << reader.extensions()
+                             .datareader_cache_status()
+                             .replaced_dropped_sample_count()
+                  << std::endl;
+    } else if (coalesce_mode == CoalesceMode::table) {
+        std::cout << "Temperature readings received: "
+                  << latest_temperatures.received()
+                  << ", superseded: " << latest_temperatures.superseded()
+                  << ", processed: " << latest_temperatures.processed()
+                  << std::endl;
     }
 }
 
-void run_example(unsigned int domain_id, unsigned int lots_to_process)
+// Reads the parameters of the temperature filter: the high and low limits.
+// Returns false if they are not two integers.
+bool parse_temperature_range(
+        const std::vector<std::string>& parameters,
+        TemperatureRange& range)
 {
+    return parameters.size() == 2
+            && parse_temperature_parameter(parameters[0], range.high)
+            && parse_temperature_parameter(parameters[1], range.low);
+}
+
+// A command read from the standard input
+struct Command {
+    enum class Kind { lots, kpis, quantiles, filter_parameters, help };
+
+    Kind kind;
+    // New filter parameters, for filter_parameters
+    FilterParameterUpdate update;
+};
+
+// Parses a command read from the standard input. The commands are run by the
+// WaitSet thread, which owns the data and the DataWriters. Reports are
+// printed, and new filter parameters are published on the
+// FilterParameterUpdate Topic.
+//
+//     lots
+//         Lots at each station and in each status.
+//     kpis
+//         Throughput, work in progress and utilization of each station.
+//     quantiles
+//         Median, 95th and 99th percentile temperature of each sensor.
+//     temperature <high> <low>
+//         Temperature range of this application. DataWriters that filter
+//         for it receive the new range with discovery.
+//     filter <filter_name> <station|ALL> <parameter>...
+//         Parameters of the ContentFilteredTopic filter_name, in the
+//         application of a station or in all of them. For example:
+//         filter FilteredLot SUGAR_CONTROLLER 'SUGAR_CONTROLLER'
+//
+// Returns false for empty lines. Invalid lines are help commands.
+bool parse_command(const std::string& line, Command& parsed)
+{
+    std::istringstream command(line);
+    std::string name;
+    if (!(command >> name)) {
+        return false;
+    }
+
+    bool valid = false;
+    if (name == "lots") {
+        parsed.kind = Command::Kind::lots;
+        valid = true;
+    } else if (name == "kpis") {
+        parsed.kind = Command::Kind::kpis;
+        valid = true;
+    } else if (name == "quantiles") {
+        parsed.kind = Command::Kind::quantiles;
+        valid = true;
+    } else if (name == "temperature") {
+        int32_t high = 0;
+        int32_t low = 0;
+        valid = static_cast<bool>(command >> high >> low);
+        parsed.kind = Command::Kind::filter_parameters;
+        parsed.update.filter_name = TEMPERATURE_FILTER_NAME;
+        parsed.update.station = StationKind::INVALID_CONTROLLER;
+        parsed.update.parameters.push_back(std::to_string(high));
+        parsed.update.parameters.push_back(std::to_string(low));
+    } else if (name == "filter") {
+        FilterParameterUpdate& update = parsed.update;
+        parsed.kind = Command::Kind::filter_parameters;
+        std::string station;
+        valid = (command >> update.filter_name >> station)
+                && station_kind_from_string(station, update.station);
+        std::string parameter;
+        while (update.parameters.size() < MAX_FILTER_PARAMETERS
+               && command >> parameter) {
+            update.parameters.push_back(parameter);
+        }
+        valid = valid && !update.parameters.empty()
+                && !(command >> parameter);
+    }
+
+    if (!valid) {
+        parsed.kind = Command::Kind::help;
+    }
+    return true;
+}
+
+void print_commands(std::ostream& out)
+{
+    out << "Commands:\n"
+           "    lots\n"
+           "    kpis\n"
+           "    quantiles\n"
+           "    temperature <high> <low>\n"
+           "    filter <filter_name> <station|ALL> <parameter>..."
+        << std::endl;
+}
+
+// Configures the token-bucket flow controller used by
+// ChocolateLotStateAsyncProfile: bursts of up to flow_burst samples, then
+// flow_rate samples per second. Returns the rate the controller sends at.
+double configure_lot_state_flow_controller(
+        dds::domain::qos::DomainParticipantQos& participant_qos,
+        unsigned int flow_rate,
+        unsigned int flow_burst)
+{
+    const std::string prefix =
+            "dds.flow_controller.token_bucket.ChocolateLotStateFlowController."
+            "token_bucket.";
+
+    // The period is derived from the rate, so no tokens are lost to integer
+    // division. Rates over 1000 per second add several tokens at once, to
+    // keep the period at 1 ms or more.
+    uint64_t tokens_per_period = (flow_rate + 999ull) / 1000;
+    uint64_t period_nanosec =
+            (tokens_per_period * 1000000000ull + flow_rate / 2) / flow_rate;
+
+    rti::core::policy::Property& property =
+            participant_qos.policy<rti::core::policy::Property>();
+    property.set({ prefix + "max_tokens",
+                   std::to_string(std::max<uint64_t>(
+                           flow_burst,
+                           tokens_per_period)) });
+    property.set({ prefix + "tokens_added_per_period",
+                   std::to_string(tokens_per_period) });
+    property.set({ prefix + "period.sec",
+                   std::to_string(period_nanosec / 1000000000) });
+    property.set({ prefix + "period.nanosec",
+                   std::to_string(period_nanosec % 1000000000) });
+
+    return tokens_per_period * 1e9 / period_nanosec;
+}
+
+void run_example(const ApplicationArguments& arguments)
+{
+    unsigned int lots_to_process = arguments.sample_count;
+    CoalesceMode coalesce_mode = arguments.coalesce_mode;
+    bool use_summaries = arguments.use_summaries;
+    // Publish lot states asynchronously when a flow rate is set
+    bool async_publish = arguments.flow_rate > 0;
+
     // Loads the QoS from the qos_profiles.xml file.
     dds::core::QosProvider qos_provider("./qos_profiles.xml");
 
     // A DomainParticipant allows an application to begin communicating in
     // a DDS domain. Typically there is one DomainParticipant per application.
     // Load DomainParticipant QoS profile
+    dds::domain::qos::DomainParticipantQos participant_qos =
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::MonitoringControlApplication",
+                    arguments.transport);
+    if (async_publish) {
+        double effective_rate = configure_lot_state_flow_controller(
+                participant_qos,
+                arguments.flow_rate,
+                arguments.flow_burst);
+        std::cout << "Lot states sent at " << effective_rate
+                  << " samples per second, in bursts of up to "
+                  << arguments.flow_burst << std::endl;
+    }
     dds::domain::DomainParticipant participant(
-            domain_id,
-            qos_provider.participant_qos(
-                    "ChocolateFactoryLibrary::MonitoringControlApplication"));
+            arguments.domain_id,
+            participant_qos);
+
+    // Register the compiled temperature filter. The tempering application
+    // registers it too, so that its DataWriter can filter.
+    if (arguments.use_custom_filter) {
+        register_temperature_range_filter(participant);
+    }
+    // Register the indexed next_station filter used by the ingredient
+    // applications, so that the lot state DataWriter filters for them
+    register_equality_index_filter<ChocolateLotState>(participant);
 
     // A Topic has a name and a datatype. Create a Topic with type
     // ChocolateLotState.  Topic name is a constant defined in the IDL file.
@@ -122,89 +896,460 @@ void run_example(unsigned int domain_id, unsigned int lots_to_process)
     dds::topic::ContentFilteredTopic<Temperature>
             filtered_temperature_topic(
                     temperature_topic,
-                    "FilteredTemperature",
+                    TEMPERATURE_FILTER_NAME,
+                    temperature_range_filter(
+                            std::to_string(TEMPERATURE_HIGH),
+                            std::to_string(TEMPERATURE_LOW),
+                            arguments.use_custom_filter));
+    // Summaries of the temperature, filtered with the same range
+    dds::topic::Topic<TemperatureSummary> summary_topic(
+            participant,
+            CHOCOLATE_TEMPERATURE_SUMMARY_TOPIC);
+    dds::topic::ContentFilteredTopic<TemperatureSummary>
+            filtered_summary_topic(
+                    summary_topic,
+                    "FilteredTemperatureSummary",
                     dds::topic::Filter(
-                            "degrees > %0 or degrees < %1",
-                            { "32", "30" }));
+                            "max_degrees > %0 or min_degrees < %1",
+                            { std::to_string(TEMPERATURE_HIGH),
+                              std::to_string(TEMPERATURE_LOW) }));
+    // Station KPIs computed from the lot states
+    dds::topic::Topic<StationKpi> kpi_topic(participant, STATION_KPI_TOPIC);
+    // Commands from the standard input change the filter parameters of this
+    // and the other applications at runtime
+    dds::topic::Topic<FilterParameterUpdate> filter_parameter_topic(
+            participant,
+            FILTER_PARAMETER_UPDATE_TOPIC);
 
     // A Publisher allows an application to create one or more DataWriters
     // Publisher QoS is configured in USER_QOS_PROFILES.xml
     dds::pub::Publisher publisher(participant);
 
-    // This DataWriter writes data on Topic "ChocolateLotState"
+    // This DataWriter writes data on Topic "ChocolateLotState". When
+    // asynchronous, bursts of lots are sent at the configured flow rate.
     dds::pub::DataWriter<ChocolateLotState> lot_state_writer(
             publisher,
             topic,
             qos_provider.datawriter_qos(
-                    "ChocolateFactoryLibrary::ChocolateLotStateProfile"));
+                    async_publish
+                            ? "ChocolateFactoryLibrary::"
+                              "ChocolateLotStateAsyncProfile"
+                            : "ChocolateFactoryLibrary::"
+                              "ChocolateLotStateProfile"));
+
+    // This DataWriter publishes the KPIs of each station every second
+    dds::pub::DataWriter<StationKpi> kpi_writer(
+            publisher,
+            kpi_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::StationKpiProfile"));
+
+    // This DataWriter publishes the filter parameters read from the
+    // standard input
+    dds::pub::DataWriter<FilterParameterUpdate> filter_parameter_writer(
+            publisher,
+            filter_parameter_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::FilterParameterUpdateProfile"));
 
     // A Subscriber allows an application to create one or more DataReaders
     // Subscriber QoS is configured in USER_QOS_PROFILES.xml
     dds::sub::Subscriber subscriber(participant);
 
-    // Create DataReader of Topic "ChocolateLotState".
+    unsigned int lots_processed = 0;
+    LotTracking lots(arguments.bulk_lots + LOT_TABLE_SPARE_CAPACITY);
+    // With a dashboard, the handlers update it instead of printing each
+    // sample, the main loop redraws it, and the messages are shown in it
+    FactoryDashboard factory_dashboard(
+            STUCK_LOT_THRESHOLD,
+            arguments.all_temperatures && !use_summaries);
+    FactoryDashboard *dashboard = arguments.dashboard_refresh_millisec > 0
+            ? &factory_dashboard
+            : nullptr;
+    std::ostream& out =
+            dashboard != nullptr ? dashboard->messages() : std::cout;
+    lots.print_updates = dashboard == nullptr;
+    // The log messages too, until the dashboard is destroyed
+    std::unique_ptr<LogRedirect> log_redirect;
+    if (dashboard != nullptr) {
+        log_redirect.reset(new LogRedirect(dashboard->log_messages()));
+    }
+    // Restore the lot table before creating the DataReader that receives the
+    // history, so that the lots in progress are known at once
+    std::unique_ptr<LotSnapshot> lot_snapshot;
+    if (!arguments.snapshot_file.empty()) {
+        restore_lot_table(arguments.snapshot_file, lots, out);
+        lot_snapshot.reset(new LotSnapshot(
+                arguments.snapshot_file,
+                lots.table.capacity()));
+    }
+
+    // Create DataReader of Topic "ChocolateLotState". Its profile allows
+    // the QueryConditions created below.
     dds::sub::DataReader<ChocolateLotState> lot_state_reader(
             subscriber,
             topic,
             qos_provider.datareader_qos(
-                    "ChocolateFactoryLibrary::ChocolateLotStateProfile"));
+                    "ChocolateFactoryLibrary::"
+                    "ChocolateLotStateMonitorProfile"));
 
-    // Add a DataReader for Temperature to this application
-    dds::sub::DataReader<Temperature> temperature_reader(
-            subscriber,
-            filtered_temperature_topic,
-            qos_provider.datareader_qos(
-                    "ChocolateFactoryLibrary::ChocolateTemperatureProfile"));
-    // Obtain the DataReader's Status Condition
+    // Add a DataReader for Temperature to this application. It reads either
+    // every temperature reading, or the summaries of the readings.
+    dds::sub::DataReader<Temperature> temperature_reader(dds::core::null);
+    dds::sub::DataReader<TemperatureSummary> summary_reader(dds::core::null);
     dds::core::cond::StatusCondition temperature_status_condition(
-            temperature_reader);
+            dds::core::null);
+    LatestTemperatureTable latest_temperatures;
+    TemperatureRange temperature_range = { TEMPERATURE_HIGH, TEMPERATURE_LOW };
+    temperature_scan::ScanStats scan_stats;
+    TemperatureQuantiles temperature_quantiles(QUANTILE_WINDOW_SEC);
+    // Anomalies are relative to the normal readings, so they are only
+    // detected when every reading is received
+    TemperatureAnomalyDetector anomaly_detector;
+    TemperatureAnomalyDetector *temperature_anomaly_detector =
+            arguments.all_temperatures ? &anomaly_detector : nullptr;
+    if (use_summaries) {
+        summary_reader = dds::sub::DataReader<TemperatureSummary>(
+                subscriber,
+                filtered_summary_topic,
+                qos_provider.datareader_qos(
+                        "ChocolateFactoryLibrary::"
+                        "ChocolateTemperatureSummaryProfile"));
+        // Obtain the DataReader's Status Condition
+        temperature_status_condition =
+                dds::core::cond::StatusCondition(summary_reader);
+
+        // Associate a handler with the status condition. This will run when
+        // the condition is triggered, in the context of the dispatch call
+        temperature_status_condition.extensions().handler(
+                [&summary_reader, dashboard]() {
+                    monitor_temperature_summary(summary_reader, dashboard);
+                });
+    } else {
+        // When coalescing with QoS, the DataReader keeps only the newest
+        // reading per sensor.
+        std::string temperature_profile = coalesce_mode == CoalesceMode::qos
+                ? "ChocolateFactoryLibrary::"
+                  "ChocolateTemperatureLatestValueProfile"
+                : "ChocolateFactoryLibrary::ChocolateTemperatureProfile";
+        // The filtered topic only receives the readings out of range. The
+        // quantiles of each sensor need all of them: monitor_temperature
+        // then finds the readings out of range.
+        if (arguments.all_temperatures) {
+            temperature_reader = dds::sub::DataReader<Temperature>(
+                    subscriber,
+                    temperature_topic,
+                    qos_provider.datareader_qos(temperature_profile));
+        } else {
+            temperature_reader = dds::sub::DataReader<Temperature>(
+                    subscriber,
+                    filtered_temperature_topic,
+                    qos_provider.datareader_qos(temperature_profile));
+        }
+        // Obtain the DataReader's Status Condition
+        temperature_status_condition =
+                dds::core::cond::StatusCondition(temperature_reader);
+
+        // Associate a handler with the status condition. This will run when
+        // the condition is triggered, in the context of the dispatch call
+        temperature_status_condition.extensions().handler([&]() {
+            if (coalesce_mode == CoalesceMode::table) {
+                monitor_latest_temperature(
+                        temperature_reader,
+                        latest_temperatures,
+                        temperature_range,
+                        scan_stats,
+                        temperature_quantiles,
+                        temperature_anomaly_detector,
+                        dashboard);
+            } else {
+                monitor_temperature(
+                        temperature_reader,
+                        temperature_range,
+                        scan_stats,
+                        temperature_quantiles,
+                        temperature_anomaly_detector,
+                        dashboard);
+            }
+        });
+    }
 
     // Enable the 'data available' status.
     temperature_status_condition.enabled_statuses(
             dds::core::status::StatusMask::data_available());
 
-    // Associate a handler with the status condition. This will run when the
-    // condition is triggered, in the context of the dispatch call (see below)
-    temperature_status_condition.extensions().handler(
-                [&temperature_reader, &temperature_status_condition]() {
-            monitor_temperature(temperature_reader);
-    });
+    // Demultiplex the lot state updates with QueryConditions on the single
+    // DataReader. The DataReader evaluates each query once per sample, and
+    // each handler takes only the samples of its condition: completed lots,
+    // and the other updates of each station.
+    using dds::sub::status::DataState;
+    dds::sub::cond::QueryCondition completed_condition(
+            dds::sub::Query(lot_state_reader, "lot_status = 'COMPLETED'"),
+            DataState::any(),
+            [&]() {
+                lots_processed += monitor_lot_state(
+                        lot_state_reader,
+                        completed_condition,
+                        "Completed Lot",
+                        lots);
+            });
 
-    // Obtain the DataReader's Status Condition
-    dds::core::cond::StatusCondition lot_state_status_condition(
-            lot_state_reader);
+    // Updates from the monitoring application itself (INVALID_CONTROLLER:
+    // lots waiting to start) and from each station
+    const StationKind stations[] = { StationKind::INVALID_CONTROLLER,
+                                      StationKind::COCOA_BUTTER_CONTROLLER,
+                                      StationKind::SUGAR_CONTROLLER,
+                                      StationKind::MILK_CONTROLLER,
+                                      StationKind::VANILLA_CONTROLLER,
+                                      StationKind::TEMPERING_CONTROLLER };
+    std::vector<dds::sub::cond::QueryCondition> station_conditions;
+    for (size_t i = 0; i < sizeof(stations) / sizeof(stations[0]); i++) {
+        // Points to a static table, so logging it only copies the pointer
+        const char *station_name = station_kind_name(stations[i]);
+        station_conditions.push_back(dds::sub::cond::QueryCondition(
+                dds::sub::Query(
+                        lot_state_reader,
+                        "station = %0 and lot_status <> 'COMPLETED'",
+                        { std::string("'") + station_name + "'" }),
+                DataState::any(),
+                [&lot_state_reader, &lots_processed, &lots,
+                 &station_conditions, i, station_name]() {
+                    lots_processed += monitor_lot_state(
+                            lot_state_reader,
+                            station_conditions[i],
+                            "Lot Update from ",
+                            lots,
+                            station_name);
+                }));
+    }
 
-    // Enable the 'data available' status.
-    lot_state_status_condition.enabled_statuses(
+    // Disposed and unregistered lots have no data for the queries to
+    // evaluate: a ReadCondition on the instance state selects them
+    dds::sub::cond::ReadCondition disposed_condition(
+            lot_state_reader,
+            DataState(
+                    dds::sub::status::SampleState::any(),
+                    dds::sub::status::ViewState::any(),
+                    dds::sub::status::InstanceState::not_alive_mask()),
+            [&]() {
+                lots_processed += monitor_lot_state(
+                        lot_state_reader,
+                        disposed_condition,
+                        "Lot Update",
+                        lots);
+            });
+
+    // Receive the updates of the temperature range, including those
+    // published by this application. The ContentFilteredTopics are updated
+    // in place, so no DataReader is recreated or rediscovered.
+    dds::sub::DataReader<FilterParameterUpdate> filter_parameter_reader =
+            create_filter_parameter_reader(
+                    subscriber,
+                    filter_parameter_topic,
+                    qos_provider,
+                    TEMPERATURE_FILTER_NAME,
+                    "INVALID_CONTROLLER");
+    dds::core::cond::StatusCondition filter_parameter_status_condition(
+            filter_parameter_reader);
+    filter_parameter_status_condition.enabled_statuses(
             dds::core::status::StatusMask::data_available());
+    filter_parameter_status_condition.extensions().handler([&]() {
+        std::vector<std::string> parameters;
+        if (!take_filter_parameters(filter_parameter_reader, parameters)) {
+            return;
+        }
+        TemperatureRange range;
+        if (!parse_temperature_range(parameters, range)) {
+            out << "Ignoring temperature range that is not two integers"
+                << std::endl;
+            return;
+        }
+        // Both ContentFilteredTopics use the new range, or neither does
+        std::vector<std::string> previous_parameters =
+                filtered_temperature_topic.filter_parameters();
+        if (!update_filter_parameters(
+                    filtered_temperature_topic,
+                    parameters,
+                    out)) {
+            return;
+        }
+        if (!update_filter_parameters(
+                    filtered_summary_topic,
+                    parameters,
+                    out)) {
+            update_filter_parameters(
+                    filtered_temperature_topic,
+                    previous_parameters,
+                    out);
+            return;
+        }
+        temperature_range = range;
+    });
 
-    // Associate a handler with the status condition. This will run when the
-    // condition is triggered, in the context of the dispatch call (see below)
-    unsigned int lots_processed = 0;
-    lot_state_status_condition.extensions().handler(
-            [&lot_state_reader, &lots_processed]() {
-        lots_processed += monitor_lot_state(lot_state_reader);
+    // Run the commands read from the standard input. The thread that reads
+    // them only parses them: the DataWriters are used by this thread.
+    CommandQueue<Command> commands;
+    dds::core::cond::GuardCondition command_condition;
+    command_condition.extensions().handler([&]() {
+        command_condition.trigger_value(false);
+        for (const Command& command : commands.take_all()) {
+            switch (command.kind) {
+            case Command::Kind::lots:
+                print_lot_table(lots.table, out);
+                print_lot_id_cache_statistics(lots.lot_ids, out);
+                print_reader_instance_statistics(
+                        lot_state_reader,
+                        lots.ended_instances,
+                        out);
+                print_writer_instance_statistics(
+                        lot_state_writer,
+                        lots_started,
+                        out);
+                break;
+            case Command::Kind::kpis:
+                lots.kpis.report(
+                        lots.table,
+                        PipelineKpis::clock::now(),
+                        [&out](const StationKpi& kpi) {
+                            print_station_kpi(kpi, out);
+                        });
+                break;
+            case Command::Kind::quantiles:
+                print_temperature_quantiles(temperature_quantiles, out);
+                break;
+            case Command::Kind::help:
+                print_commands(out);
+                break;
+            case Command::Kind::filter_parameters:
+                filter_parameter_writer.write(command.update);
+                break;
+            }
+        }
     });
 
     // Create a WaitSet and attach the StatusCondition
     dds::core::cond::WaitSet waitset;
-    waitset += lot_state_status_condition;
+    waitset += completed_condition;
+    for (const auto& condition : station_conditions) {
+        waitset += condition;
+    }
+    waitset += disposed_condition;
     // Add the new DataReader's StatusCondition to the Waitset
     waitset += temperature_status_condition;
+    waitset += filter_parameter_status_condition;
+    waitset += command_condition;
 
     // Create a thread to periodically start new chocolate lots
+    std::atomic<uint64_t> lots_started(0);
     std::thread start_lot_thread(
             publish_start_lot,
             lot_state_writer,
-            lots_to_process);
+            lots_to_process,
+            arguments.bulk_lots,
+            lots.print_updates,
+            std::ref(lots_started));
 
+    // Create a thread to read commands. It is joined when command_reader is
+    // destroyed, before the GuardCondition and the queue it uses.
+    CommandReader command_reader([&](const std::string& line) {
+        Command command;
+        if (parse_command(line, command)) {
+            commands.push(std::move(command));
+            command_condition.trigger_value(true);
+        }
+    });
+
+    // Print how many temperatures and lots the filters drop, and where,
+    // every statistics_period_sec seconds
+    StatisticsPeriod statistics_period(arguments.statistics_period_sec);
+    // Publish the station KPIs every second
+    StatisticsPeriod kpi_period(1);
+    // Checkpoint the lot table, if there is a snapshot file
+    StatisticsPeriod snapshot_period(lot_snapshot ? SNAPSHOT_PERIOD_SEC : 0);
+    // Redraw the dashboard, if there is one
+    StatisticsPeriod dashboard_period(
+            std::chrono::milliseconds(arguments.dashboard_refresh_millisec));
+    // Check whether the lot state history has arrived, while catching up
+    StatisticsPeriod historical_data_period(HISTORICAL_DATA_POLL_PERIOD);
     while (!shutdown_requested && lots_processed < lots_to_process) {
         // Dispatch will call the handlers associated to the WaitSet conditions
-        // when they activate
-        waitset.dispatch(dds::core::Duration(10));  // Wait up to 10s each time
+        // when they activate. Wait up to 10s each time.
+        dds::core::Duration max_wait = dashboard_period.wait_time(
+                kpi_period.wait_time(statistics_period.wait_time(
+                        dds::core::Duration(10))));
+        if (lots.catch_up.active()) {
+            max_wait = historical_data_period.wait_time(max_wait);
+        }
+        waitset.dispatch(max_wait);
+        if (lots.catch_up.active() && historical_data_period.due()
+                && historical_data_received(
+                        lot_state_reader,
+                        lot_state_writer.instance_handle())) {
+            lots.catch_up.history_complete();
+        }
+        // Print the progress of catching up with the lot state history. Once
+        // the history has arrived, the restored lots it did not confirm were
+        // completed while the application was down.
+        if (lots.catch_up.update(PipelineKpis::clock::now(), out)) {
+            if (lots.catch_up.received_history()) {
+                expire_restored_lots(lots, out);
+            }
+            if (lots.print_updates) {
+                print_lot_table(lots.table, out);
+            }
+        }
+        if (dashboard_period.due()) {
+            dashboard->draw(
+                    lots.table,
+                    lots.kpis,
+                    PipelineKpis::clock::now(),
+                    std::cout);
+        }
+        if (kpi_period.due()) {
+            lots.kpis.report(
+                    lots.table,
+                    PipelineKpis::clock::now(),
+                    [&kpi_writer](const StationKpi& kpi) {
+                        kpi_writer.write(kpi);
+                    });
+        }
+        if (snapshot_period.due()) {
+            lot_snapshot->checkpoint(lots.table);
+        }
+        if (statistics_period.due()) {
+            if (use_summaries) {
+                print_reader_filter_statistics(summary_reader, out);
+            } else {
+                print_reader_filter_statistics(temperature_reader, out);
+            }
+            print_writer_filter_statistics(lot_state_writer, out);
+            print_lot_id_cache_statistics(lots.lot_ids, out);
+            print_reader_instance_statistics(
+                    lot_state_reader,
+                    lots.ended_instances,
+                    out);
+            print_writer_instance_statistics(
+                    lot_state_writer,
+                    lots_started,
+                    out);
+        }
     }
 
     start_lot_thread.join();
+    command_reader.stop();
+
+    // A clean shutdown leaves the latest lot table in the snapshot
+    if (lot_snapshot) {
+        lot_snapshot->checkpoint(lots.table);
+    }
+
+    if (!use_summaries) {
+        print_coalescing_statistics(
+                coalesce_mode,
+                temperature_reader,
+                latest_temperatures);
+        print_scan_statistics(scan_stats);
+    }
 }
 
 int main(int argc, char *argv[])
@@ -221,8 +1366,11 @@ int main(int argc, char *argv[])
     // Sets Connext verbosity to help debugging
     rti::config::Logger::instance().verbosity(arguments.verbosity);
 
+    // Writes the log messages of the data paths in the background
+    LogWriter log_writer(arguments.log_level);
+
     try {
-        run_example(arguments.domain_id, arguments.sample_count);
+        run_example(arguments);
     } catch (const std::exception& ex) {
         // This will catch DDS exceptions
         std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
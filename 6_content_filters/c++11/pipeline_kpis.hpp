@@ -0,0 +1,251 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef PIPELINE_KPIS_HPP
+#define PIPELINE_KPIS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "chocolate_factory.hpp"
+#include "lot_table.hpp"
+
+// Key performance indicators of each station, computed incrementally from
+// the lot state transitions over a sliding window of window_sec seconds.
+//
+// The window is a ring of one-second buckets: a transition updates the
+// counters of the current bucket, and computing the indicators adds up the
+// buckets, so neither depends on the number of lots.
+//
+// For each station:
+// - arrival: a lot starts waiting for the station
+// - service: from PROCESSING to COMPLETED by the station
+// - time in station: from arrival to COMPLETED by the station
+// - utilization = throughput x mean service time, and mean work in
+//   progress = throughput x mean time in station (Little's law)
+class PipelineKpis {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    explicit PipelineKpis(unsigned int window_sec)
+            : buckets(window_sec > 0 ? window_sec : 1),
+              start_time(clock::now()),
+              current_second(0)
+    {
+    }
+
+    // Records the update of a lot. previous is its state before the update,
+    // or nullptr for a new lot.
+    void update(
+            const LotTable::LotRecord *previous,
+            const ChocolateLotState& state,
+            clock::time_point now)
+    {
+        Bucket& bucket = advance(now);
+        LotTimes& times = lot_times[state.lot_id];
+
+        bool was_processing = previous != nullptr
+                && previous->lot_status == LotStatusKind::PROCESSING
+                && previous->station == state.station;
+        if (state.lot_status == LotStatusKind::PROCESSING && !was_processing) {
+            times.service_station = state.station;
+            times.service_start = now;
+        }
+
+        bool was_completed = previous != nullptr
+                && previous->lot_status == LotStatusKind::COMPLETED
+                && previous->station == state.station;
+        if (state.lot_status == LotStatusKind::COMPLETED && !was_completed) {
+            Counters& counters = bucket.stations[station_index(state.station)];
+            counters.completions++;
+            if (times.service_station == state.station) {
+                counters.service_sec += seconds(now - times.service_start);
+                counters.service_count++;
+                times.service_station = StationKind::INVALID_CONTROLLER;
+            }
+            if (times.arrival_station == state.station) {
+                counters.time_in_station_sec +=
+                        seconds(now - times.arrival_time);
+                counters.time_in_station_count++;
+            }
+        }
+
+        // A lot completed by a station arrives at the next one
+        StationKind location = state.lot_status == LotStatusKind::PROCESSING
+                ? state.station
+                : state.next_station;
+        if (previous == nullptr || LotTable::location(*previous) != location) {
+            bucket.stations[station_index(location)].arrivals++;
+            times.arrival_station = location;
+            times.arrival_time = now;
+        }
+    }
+
+    // Forgets a lot that is no longer tracked
+    void remove(uint32_t lot_id)
+    {
+        lot_times.erase(lot_id);
+    }
+
+    // Calls function(uint32_t lot_id, StationKind station, double sec) for
+    // each lot that arrived at its station at least threshold ago. Takes
+    // time proportional to the number of lots.
+    template <typename Function>
+    void for_each_stuck(
+            clock::time_point now,
+            clock::duration threshold,
+            Function function) const
+    {
+        for (const auto& entry : lot_times) {
+            const LotTimes& times = entry.second;
+            if (times.arrival_station != StationKind::INVALID_CONTROLLER
+                && now - times.arrival_time >= threshold) {
+                function(
+                        entry.first,
+                        times.arrival_station,
+                        seconds(now - times.arrival_time));
+            }
+        }
+    }
+
+    // Calls function(const StationKpi&) with the indicators of each station.
+    // The current work in progress comes from the lot table.
+    template <typename Function>
+    void report(
+            const LotTable& lot_table,
+            clock::time_point now,
+            Function function)
+    {
+        advance(now);
+        // The window is shorter until window_sec seconds have elapsed
+        double window_sec = static_cast<double>(buckets.size());
+        double elapsed_sec = seconds(now - start_time);
+        if (elapsed_sec < window_sec) {
+            window_sec = elapsed_sec > 1 ? elapsed_sec : 1;
+        }
+
+        for (size_t station = 1; station < LotTable::STATION_COUNT;
+             station++) {
+            Counters total;
+            for (const Bucket& bucket : buckets) {
+                total += bucket.stations[station];
+            }
+
+            StationKpi kpi;
+            kpi.station = static_cast<StationKind>(station);
+            kpi.window_sec = static_cast<uint32_t>(buckets.size());
+            kpi.arrivals = total.arrivals;
+            kpi.completions = total.completions;
+            kpi.work_in_progress = static_cast<uint32_t>(
+                    lot_table.count_at_station(kpi.station));
+            kpi.throughput_per_sec = total.completions / window_sec;
+            kpi.mean_service_sec = total.service_count > 0
+                    ? total.service_sec / total.service_count
+                    : 0;
+            kpi.mean_time_in_station_sec = total.time_in_station_count > 0
+                    ? total.time_in_station_sec / total.time_in_station_count
+                    : 0;
+            kpi.utilization = kpi.throughput_per_sec * kpi.mean_service_sec;
+            kpi.mean_work_in_progress =
+                    kpi.throughput_per_sec * kpi.mean_time_in_station_sec;
+            function(kpi);
+        }
+    }
+
+private:
+    struct Counters {
+        Counters()
+                : arrivals(0),
+                  completions(0),
+                  service_sec(0),
+                  service_count(0),
+                  time_in_station_sec(0),
+                  time_in_station_count(0)
+        {
+        }
+
+        Counters& operator+=(const Counters& other)
+        {
+            arrivals += other.arrivals;
+            completions += other.completions;
+            service_sec += other.service_sec;
+            service_count += other.service_count;
+            time_in_station_sec += other.time_in_station_sec;
+            time_in_station_count += other.time_in_station_count;
+            return *this;
+        }
+
+        uint32_t arrivals;
+        uint32_t completions;
+        double service_sec;
+        uint32_t service_count;
+        double time_in_station_sec;
+        uint32_t time_in_station_count;
+    };
+
+    struct Bucket {
+        Counters stations[LotTable::STATION_COUNT];
+    };
+
+    // When the lot arrived at its station, and started being processed
+    struct LotTimes {
+        LotTimes()
+                : arrival_station(StationKind::INVALID_CONTROLLER),
+                  service_station(StationKind::INVALID_CONTROLLER)
+        {
+        }
+
+        StationKind arrival_station;
+        clock::time_point arrival_time;
+        StationKind service_station;
+        clock::time_point service_start;
+    };
+
+    static double seconds(clock::duration duration)
+    {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    static size_t station_index(StationKind station)
+    {
+        size_t index = static_cast<size_t>(station);
+        return index < LotTable::STATION_COUNT ? index : 0;
+    }
+
+    // Clears the buckets of the seconds that passed since the last call, and
+    // returns the bucket of the current second
+    Bucket& advance(clock::time_point now)
+    {
+        uint64_t second = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::seconds>(
+                        now - start_time)
+                        .count());
+        uint64_t cleared = 0;
+        while (current_second < second && cleared < buckets.size()) {
+            current_second++;
+            cleared++;
+            buckets[current_second % buckets.size()] = Bucket();
+        }
+        current_second = second > current_second ? second : current_second;
+        return buckets[current_second % buckets.size()];
+    }
+
+    std::vector<Bucket> buckets;
+    clock::time_point start_time;
+    uint64_t current_second;
+    // Times of the lots being tracked. Entries are removed with the lot.
+    std::unordered_map<uint32_t, LotTimes> lot_times;
+};
+
+#endif  // PIPELINE_KPIS_HPP
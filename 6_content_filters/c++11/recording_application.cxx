@@ -0,0 +1,262 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <dds/sub/ddssub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "statistics_period.hpp"  // Periodic tasks
+#include "sample_recording.hpp"  // Memory-mapped segment files
+
+using namespace application;
+
+// Recording application:
+// Records every sample of the ChocolateTemperature and ChocolateLotState
+// Topics with its SampleInfo, to analyze an incident afterwards. See
+// sample_recording.hpp for the format of the recording.
+//
+// The samples are taken in batches in the WaitSet thread, serialized again
+// into a reused buffer, and appended to the memory-mapped segment: recording
+// a sample allocates no memory and waits for no file operation.
+//
+// -o, --recording sets the directory of the recording, -z, --segment-size
+// the size of each segment file, -s, --sample-count the number of samples
+// recorded before stopping, and -p, --statistics-period how often the
+// recording statistics are printed.
+
+int64_t time_nanosec(const dds::core::Time& time)
+{
+    return time.sec() * 1000000000LL + time.nanosec();
+}
+
+recording::InstanceState instance_state(const dds::sub::SampleInfo& info)
+{
+    using dds::sub::status::InstanceState;
+    if (info.state().instance_state() == InstanceState::not_alive_disposed()) {
+        return recording::InstanceState::disposed;
+    } else if (
+            info.state().instance_state()
+            == InstanceState::not_alive_no_writers()) {
+        return recording::InstanceState::no_writers;
+    }
+    return recording::InstanceState::alive;
+}
+
+// Records the samples of the DataReader of a Topic
+template <typename T>
+class TopicRecorder {
+public:
+    TopicRecorder(
+            const dds::sub::DataReader<T>& reader,
+            recording::Topic topic,
+            recording::Recorder& recorder)
+            : reader(reader), topic(topic), recorder(recorder), recorded(0)
+    {
+    }
+
+    // Takes and records the samples available. Returns how many.
+    unsigned int record_available()
+    {
+        dds::sub::LoanedSamples<T> samples = reader.take();
+        for (const auto& sample : samples) {
+            const dds::sub::SampleInfo& info = sample.info();
+            recording::RecordHeader header = {};
+            header.topic = static_cast<uint8_t>(topic);
+            header.valid_data = info.valid() ? 1 : 0;
+            header.instance_state = static_cast<uint8_t>(instance_state(info));
+            header.source_timestamp_ns = time_nanosec(info.source_timestamp());
+            header.reception_timestamp_ns =
+                    time_nanosec(info.extensions().reception_timestamp());
+            std::memcpy(
+                    header.writer_guid,
+                    info.extensions()
+                            .original_publication_virtual_guid()
+                            .native()
+                            .value,
+                    sizeof(header.writer_guid));
+            // The key hash of the native handle. Its layout is not part of
+            // the documented API, but the recording needs the raw bytes.
+            std::memcpy(
+                    header.instance_handle,
+                    info.instance_handle()->native().keyHash.value,
+                    sizeof(header.instance_handle));
+
+            // A sample without valid data only records the instance state
+            cdr_buffer.clear();
+            if (info.valid()) {
+                dds::topic::topic_type_support<T>::to_cdr_buffer(
+                        cdr_buffer,
+                        sample.data());
+            }
+            recorder.record(header, cdr_buffer.data(), cdr_buffer.size());
+        }
+        recorded += samples.length();
+        return samples.length();
+    }
+
+    void print_statistics() const
+    {
+        std::cout << "    " << reader.topic_description().name() << ": "
+                  << recorded << " recorded, "
+                  << reader.sample_lost_status().total_count() << " lost, "
+                  << reader.sample_rejected_status().total_count()
+                  << " rejected" << std::endl;
+    }
+
+private:
+    dds::sub::DataReader<T> reader;
+    recording::Topic topic;
+    recording::Recorder& recorder;
+    uint64_t recorded;
+    // Reused for every sample: its capacity grows to the largest sample
+    std::vector<char> cdr_buffer;
+};
+
+void print_recording_statistics(
+        const recording::Recorder& recorder,
+        const TopicRecorder<Temperature>& temperature_recorder,
+        const TopicRecorder<ChocolateLotState>& lot_state_recorder)
+{
+    std::cout << "Recording: " << recorder.records() << " samples, "
+              << recorder.bytes() / (1024 * 1024) << " MB in "
+              << recorder.segments() << " segments, waited for "
+              << recorder.rollover_waits() << " segments" << std::endl;
+    temperature_recorder.print_statistics();
+    lot_state_recorder.print_statistics();
+}
+
+void run_example(const ApplicationArguments& arguments)
+{
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+
+    // The segments follow those already in the directory
+    recording::Recorder recorder(
+            arguments.recording_directory,
+            static_cast<size_t>(arguments.segment_size_mb) * 1024 * 1024);
+
+    // A DomainParticipant allows an application to begin communicating in
+    // a DDS domain. Typically there is one DomainParticipant per application.
+    // Load DomainParticipant QoS profile
+    dds::domain::DomainParticipant participant(
+            arguments.domain_id,
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::RecordingApplication",
+                    arguments.transport));
+
+    // The Topics are not filtered: every sample is recorded
+    dds::topic::Topic<Temperature> temperature_topic(
+            participant,
+            CHOCOLATE_TEMPERATURE_TOPIC);
+    dds::topic::Topic<ChocolateLotState> lot_state_topic(
+            participant,
+            CHOCOLATE_LOT_STATE_TOPIC);
+
+    // A Subscriber allows an application to create one or more DataReaders
+    dds::sub::Subscriber subscriber(participant);
+    dds::sub::DataReader<Temperature> temperature_reader(
+            subscriber,
+            temperature_topic,
+            qos_provider.datareader_qos(
+                    "ChocolateFactoryLibrary::"
+                    "ChocolateTemperatureRecorderProfile"));
+    dds::sub::DataReader<ChocolateLotState> lot_state_reader(
+            subscriber,
+            lot_state_topic,
+            qos_provider.datareader_qos(
+                    "ChocolateFactoryLibrary::"
+                    "ChocolateLotStateRecorderProfile"));
+
+    TopicRecorder<Temperature> temperature_recorder(
+            temperature_reader,
+            recording::Topic::temperature,
+            recorder);
+    TopicRecorder<ChocolateLotState> lot_state_recorder(
+            lot_state_reader,
+            recording::Topic::lot_state,
+            recorder);
+
+    // Every sample, including those that only change the instance state
+    unsigned int samples_recorded = 0;
+    using dds::sub::status::DataState;
+    dds::sub::cond::ReadCondition temperature_condition(
+            temperature_reader,
+            DataState::any(),
+            [&]() {
+                samples_recorded += temperature_recorder.record_available();
+            });
+    dds::sub::cond::ReadCondition lot_state_condition(
+            lot_state_reader,
+            DataState::any(),
+            [&]() {
+                samples_recorded += lot_state_recorder.record_available();
+            });
+
+    dds::core::cond::WaitSet waitset;
+    waitset += temperature_condition;
+    waitset += lot_state_condition;
+
+    std::cout << "Recording to " << arguments.recording_directory << std::endl;
+    StatisticsPeriod statistics_period(arguments.statistics_period_sec);
+    while (!shutdown_requested && samples_recorded < arguments.sample_count) {
+        // Dispatch will call the handlers associated to the WaitSet conditions
+        // when they activate. Wait up to 10s each time.
+        waitset.dispatch(statistics_period.wait_time(dds::core::Duration(10)));
+        if (statistics_period.due()) {
+            print_recording_statistics(
+                    recorder,
+                    temperature_recorder,
+                    lot_state_recorder);
+        }
+    }
+
+    print_recording_statistics(
+            recorder,
+            temperature_recorder,
+            lot_state_recorder);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
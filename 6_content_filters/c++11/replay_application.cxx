@@ -0,0 +1,410 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "statistics_period.hpp"  // Periodic tasks
+#include "sample_recording.hpp"  // Memory-mapped segment files
+
+using namespace application;
+
+// Replay application:
+// Publishes the samples of a recording of the recording application back on
+// the ChocolateTemperature and ChocolateLotState Topics, so that the
+// stations and the monitor see the recorded workload in the lab.
+//
+// The records are replayed in the order they were recorded, so the samples
+// of each instance keep their order, and the same recording always gives
+// the same sequence of samples. Each sample is written after the time that
+// separated its reception from that of the first record, divided by the
+// speed. Disposed and unregistered instances are disposed and unregistered
+// again.
+//
+// With more than one replica, each sample is written once more per replica,
+// with another sensor_id or lot_id: sensor "2" is also sensor "2.1", "2.2",
+// and lot 7 is also lot 1000007, 2000007, and so on.
+//
+// -o, --recording sets the directory of the recording, -e, --speed the
+// speed, -n, --replicas the number of replicas, -s, --sample-count the
+// number of records replayed, and -p, --statistics-period how often the
+// requested and achieved rates are printed.
+
+// lot_id added for each replica of a lot
+const uint32_t REPLICA_LOT_ID_STRIDE = 1000000;
+
+// Key hash of an instance, as recorded
+typedef std::array<uint8_t, 16> KeyHash;
+
+struct KeyHashHash {
+    size_t operator()(const KeyHash& key_hash) const
+    {
+        // The key hash is already a hash: any 8 of its bytes will do
+        uint64_t value;
+        std::memcpy(&value, key_hash.data(), sizeof(value));
+        return static_cast<size_t>(value);
+    }
+};
+
+void make_replica(
+        const Temperature& original,
+        unsigned int replica,
+        Temperature& sample)
+{
+    sample = original;
+    if (replica > 0) {
+        sample.sensor_id += '.';
+        sample.sensor_id += std::to_string(replica);
+    }
+}
+
+void make_replica(
+        const ChocolateLotState& original,
+        unsigned int replica,
+        ChocolateLotState& sample)
+{
+    sample = original;
+    sample.lot_id += replica * REPLICA_LOT_ID_STRIDE;
+}
+
+// Writes the records of a Topic, and their replicas
+template <typename T>
+class TopicReplayer {
+public:
+    TopicReplayer(
+            const dds::pub::DataWriter<T>& writer,
+            unsigned int replica_count)
+            : writer(writer),
+              replica_count(replica_count),
+              written(0),
+              unknown_instances(0)
+    {
+    }
+
+    void replay(
+            const recording::RecordHeader& record,
+            const unsigned char *payload)
+    {
+        KeyHash key_hash;
+        std::memcpy(
+                key_hash.data(),
+                record.instance_handle,
+                sizeof(record.instance_handle));
+        if (record.valid_data) {
+            cdr_buffer.assign(payload, payload + record.payload_size);
+            dds::topic::topic_type_support<T>::from_cdr_buffer(
+                    sample,
+                    cdr_buffer);
+            // The key of the instance, for its dispose or unregister
+            keys[key_hash] = sample;
+            for (unsigned int replica = 0; replica < replica_count; replica++) {
+                make_replica(sample, replica, replica_sample);
+                writer.write(replica_sample);
+            }
+            written += replica_count;
+            return;
+        }
+
+        // A sample without data notifies a change of the instance state
+        auto key = keys.find(key_hash);
+        if (key == keys.end()) {
+            // The instance has no valid sample in the recording
+            unknown_instances++;
+            return;
+        }
+        for (unsigned int replica = 0; replica < replica_count; replica++) {
+            make_replica(key->second, replica, replica_sample);
+            dds::core::InstanceHandle instance_handle =
+                    writer.lookup_instance(replica_sample);
+            if (instance_handle.is_nil()) {
+                continue;
+            }
+            if (record.instance_state
+                == static_cast<uint8_t>(recording::InstanceState::disposed)) {
+                writer.dispose_instance(instance_handle);
+            } else {
+                writer.unregister_instance(instance_handle);
+            }
+        }
+        keys.erase(key);
+    }
+
+    void print_statistics() const
+    {
+        std::cout << "    " << writer.topic().name() << ": " << written
+                  << " written, " << keys.size() << " instances alive";
+        if (unknown_instances > 0) {
+            std::cout << ", " << unknown_instances
+                      << " state changes of unknown instances";
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    dds::pub::DataWriter<T> writer;
+    unsigned int replica_count;
+    uint64_t written;
+    uint64_t unknown_instances;
+    // Reused for every record
+    std::vector<char> cdr_buffer;
+    T sample;
+    T replica_sample;
+    // Last sample of each instance alive
+    std::unordered_map<KeyHash, T, KeyHashHash> keys;
+};
+
+// When each record is due: after the first one, by the time between their
+// receptions divided by the speed. A speed of 0 replays as fast as possible.
+class ReplaySchedule {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    explicit ReplaySchedule(double speed)
+            : speed(speed),
+              started(false),
+              first_reception_ns(0),
+              last_offset(0),
+              max_lag(0)
+    {
+    }
+
+    // Waits until the record received at reception_ns is due
+    void wait_for(int64_t reception_ns)
+    {
+        if (!started) {
+            start_time = clock::now();
+            first_reception_ns = reception_ns;
+            started = true;
+        }
+        if (speed == 0) {
+            return;
+        }
+        // Records taken by different DataReaders may be a little out of
+        // reception order: the schedule never goes back
+        std::chrono::nanoseconds offset(static_cast<int64_t>(
+                (reception_ns - first_reception_ns) / speed));
+        if (offset > last_offset) {
+            last_offset = offset;
+        }
+        clock::time_point due = start_time + last_offset;
+        clock::time_point now = clock::now();
+        if (now < due) {
+            std::this_thread::sleep_until(due);
+        } else if (now - due > max_lag) {
+            max_lag = now - due;
+        }
+    }
+
+    // Time since the first record
+    double elapsed_seconds() const
+    {
+        if (!started) {
+            return 0;
+        }
+        return std::chrono::duration<double>(clock::now() - start_time)
+                .count();
+    }
+
+    // Time the records replayed so far should have taken
+    double scheduled_seconds() const
+    {
+        return std::chrono::duration<double>(last_offset).count();
+    }
+
+    // Most a record was written after it was due
+    double max_lag_seconds() const
+    {
+        return std::chrono::duration<double>(max_lag).count();
+    }
+
+    double requested_speed() const
+    {
+        return speed;
+    }
+
+private:
+    double speed;
+    bool started;
+    clock::time_point start_time;
+    int64_t first_reception_ns;
+    std::chrono::nanoseconds last_offset;
+    clock::duration max_lag;
+};
+
+void print_replay_statistics(
+        uint64_t records_replayed,
+        unsigned int replica_count,
+        const ReplaySchedule& schedule,
+        const TopicReplayer<Temperature>& temperature_replayer,
+        const TopicReplayer<ChocolateLotState>& lot_state_replayer)
+{
+    uint64_t samples = records_replayed * replica_count;
+    double elapsed = schedule.elapsed_seconds();
+    std::cout << "Replay: " << records_replayed << " records, " << samples
+              << " samples in " << elapsed << " s" << std::endl;
+    std::cout << "    rate: ";
+    if (schedule.requested_speed() == 0) {
+        std::cout << "requested as fast as possible";
+    } else if (schedule.scheduled_seconds() > 0) {
+        std::cout << "requested " << samples / schedule.scheduled_seconds()
+                  << " samples/s";
+    } else {
+        std::cout << "requested -";
+    }
+    if (elapsed > 0) {
+        std::cout << ", achieved " << samples / elapsed << " samples/s";
+    }
+    if (schedule.requested_speed() != 0) {
+        std::cout << ", at most " << schedule.max_lag_seconds() * 1000
+                  << " ms late";
+    }
+    std::cout << std::endl;
+    temperature_replayer.print_statistics();
+    lot_state_replayer.print_statistics();
+}
+
+void run_example(const ApplicationArguments& arguments)
+{
+    std::vector<uint32_t> segment_numbers =
+            recording::list_segments(arguments.recording_directory);
+    if (segment_numbers.empty()) {
+        throw std::runtime_error(
+                "No recording in " + arguments.recording_directory);
+    }
+
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+
+    // A DomainParticipant allows an application to begin communicating in
+    // a DDS domain. Typically there is one DomainParticipant per application.
+    // Load DomainParticipant QoS profile
+    dds::domain::DomainParticipant participant(
+            arguments.domain_id,
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::ReplayApplication",
+                    arguments.transport));
+
+    dds::topic::Topic<Temperature> temperature_topic(
+            participant,
+            CHOCOLATE_TEMPERATURE_TOPIC);
+    dds::topic::Topic<ChocolateLotState> lot_state_topic(
+            participant,
+            CHOCOLATE_LOT_STATE_TOPIC);
+
+    // The DataWriters have the QoS of the applications that were recorded
+    dds::pub::Publisher publisher(participant);
+    dds::pub::DataWriter<Temperature> temperature_writer(
+            publisher,
+            temperature_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::ChocolateTemperatureProfile"));
+    dds::pub::DataWriter<ChocolateLotState> lot_state_writer(
+            publisher,
+            lot_state_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::ChocolateLotStateProfile"));
+
+    TopicReplayer<Temperature> temperature_replayer(
+            temperature_writer,
+            arguments.replica_count);
+    TopicReplayer<ChocolateLotState> lot_state_replayer(
+            lot_state_writer,
+            arguments.replica_count);
+
+    std::cout << "Replaying " << segment_numbers.size() << " segments of "
+              << arguments.recording_directory << std::endl;
+    ReplaySchedule schedule(arguments.replay_speed);
+    StatisticsPeriod statistics_period(arguments.statistics_period_sec);
+    uint64_t records_replayed = 0;
+    for (uint32_t number : segment_numbers) {
+        if (shutdown_requested || records_replayed >= arguments.sample_count) {
+            break;
+        }
+        recording::SegmentReader segment(recording::segment_path(
+                arguments.recording_directory,
+                number));
+        for (uint32_t position = 0; position < segment.count(); position++) {
+            if (shutdown_requested
+                || records_replayed >= arguments.sample_count) {
+                break;
+            }
+            const recording::RecordHeader& record = segment.record(position);
+            schedule.wait_for(record.reception_timestamp_ns);
+            if (record.topic
+                == static_cast<uint8_t>(recording::Topic::temperature)) {
+                temperature_replayer.replay(record, segment.payload(position));
+            } else if (
+                    record.topic
+                    == static_cast<uint8_t>(recording::Topic::lot_state)) {
+                lot_state_replayer.replay(record, segment.payload(position));
+            }
+            records_replayed++;
+
+            if (statistics_period.due()) {
+                print_replay_statistics(
+                        records_replayed,
+                        arguments.replica_count,
+                        schedule,
+                        temperature_replayer,
+                        lot_state_replayer);
+            }
+        }
+    }
+
+    print_replay_statistics(
+            records_replayed,
+            arguments.replica_count,
+            schedule,
+            temperature_replayer,
+            lot_state_replayer);
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
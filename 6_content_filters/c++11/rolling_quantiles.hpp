@@ -0,0 +1,265 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef ROLLING_QUANTILES_HPP
+#define ROLLING_QUANTILES_HPP
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+
+// Histogram of int32 values with log-sized buckets: exact for values
+// between -63 and 63, and 4 buckets per power of two beyond, so the
+// quantiles of larger values are within 12.5%. Its size is fixed:
+// BUCKET_COUNT counters.
+class LogHistogram {
+public:
+    static const uint32_t EXACT_LIMIT = 64;
+    static const uint32_t SUB_BUCKETS = 4;
+    // Powers of two from EXACT_LIMIT (2^6) to 2^31
+    static const uint32_t OCTAVES = 26;
+    // Buckets for each sign, and in total
+    static const uint32_t HALF_COUNT = EXACT_LIMIT + OCTAVES * SUB_BUCKETS;
+    static const uint32_t BUCKET_COUNT = 2 * HALF_COUNT;
+
+    LogHistogram()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            counts[i] = 0;
+        }
+        total = 0;
+    }
+
+    void add(int32_t value)
+    {
+        counts[bucket_index(value)]++;
+        total++;
+    }
+
+    void merge(const LogHistogram& other)
+    {
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+    }
+
+    uint64_t count() const
+    {
+        return total;
+    }
+
+    // Returns the value at quantile q (0 to 1), or 0 if the histogram is
+    // empty. Buckets are ordered by value: the first bucket whose cumulative
+    // count reaches the rank, ceil(q * count), holds the quantile.
+    int32_t quantile(double q) const
+    {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+        if (rank < 1) {
+            rank = 1;
+        } else if (rank > total) {
+            rank = total;
+        }
+        uint64_t cumulative = 0;
+        for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+            cumulative += counts[i];
+            if (cumulative >= rank) {
+                return bucket_value(i);
+            }
+        }
+        return bucket_value(BUCKET_COUNT - 1);
+    }
+
+private:
+    // Index of a magnitude within the buckets of its sign
+    static uint32_t magnitude_index(uint32_t magnitude)
+    {
+        if (magnitude < EXACT_LIMIT) {
+            return magnitude;
+        }
+        uint32_t exponent = 6;
+        while (exponent < 31 && (magnitude >> (exponent + 1)) != 0) {
+            exponent++;
+        }
+        uint32_t sub_bucket = (magnitude >> (exponent - 2)) & (SUB_BUCKETS - 1);
+        return EXACT_LIMIT + (exponent - 6) * SUB_BUCKETS + sub_bucket;
+    }
+
+    // Middle of the magnitudes of a bucket
+    static int64_t magnitude_value(uint32_t index)
+    {
+        if (index < EXACT_LIMIT) {
+            return index;
+        }
+        uint32_t exponent = (index - EXACT_LIMIT) / SUB_BUCKETS + 6;
+        uint32_t sub_bucket = (index - EXACT_LIMIT) % SUB_BUCKETS;
+        int64_t width = int64_t(1) << (exponent - 2);
+        return (SUB_BUCKETS + sub_bucket) * width + width / 2;
+    }
+
+    // Negative values are stored below HALF_COUNT in reverse order, so that
+    // the buckets are ordered by value
+    static uint32_t bucket_index(int32_t value)
+    {
+        if (value < 0) {
+            uint32_t magnitude = static_cast<uint32_t>(-(int64_t(value)));
+            return HALF_COUNT - 1 - magnitude_index(magnitude);
+        }
+        return HALF_COUNT + magnitude_index(static_cast<uint32_t>(value));
+    }
+
+    static int32_t bucket_value(uint32_t index)
+    {
+        int64_t value = index < HALF_COUNT
+                ? -magnitude_value(HALF_COUNT - 1 - index)
+                : magnitude_value(index - HALF_COUNT);
+        if (value > (std::numeric_limits<int32_t>::max)()) {
+            return (std::numeric_limits<int32_t>::max)();
+        }
+        if (value < (std::numeric_limits<int32_t>::min)()) {
+            return (std::numeric_limits<int32_t>::min)();
+        }
+        return static_cast<int32_t>(value);
+    }
+
+    uint32_t counts[BUCKET_COUNT];
+    uint64_t total;
+};
+
+// Quantiles of the values of each sensor over a rolling window.
+//
+// The window is divided into SLICE_COUNT slices, each with a LogHistogram.
+// Values are added to the histogram of the current slice, and the oldest
+// slice is cleared when a new one starts. The quantiles are those of the
+// last SLICE_COUNT complete slices and of the current one: they cover
+// between window_sec and window_sec * 5 / 4 seconds. Memory per sensor is
+// constant: SLICE_COUNT + 1 histograms of LogHistogram::BUCKET_COUNT
+// counters (about 6.6 KB), plus its key and name.
+template <typename Key>
+class RollingQuantiles {
+public:
+    typedef std::chrono::steady_clock clock;
+    static const uint32_t SLICE_COUNT = 4;
+    // The complete slices and the current one
+    static const uint32_t HISTOGRAM_COUNT = SLICE_COUNT + 1;
+
+    explicit RollingQuantiles(unsigned int window_sec)
+            : slice_duration(std::chrono::milliseconds(
+                    (window_sec > 0 ? window_sec : 1) * 1000 / SLICE_COUNT)),
+              window_sec(window_sec),
+              start_time(clock::now())
+    {
+    }
+
+    // Adds a value of a sensor. name is only copied for a new sensor.
+    void add(
+            const Key& key,
+            const std::string& name,
+            int32_t value,
+            clock::time_point now)
+    {
+        auto it = sensors.find(key);
+        if (it == sensors.end()) {
+            it = sensors.insert(std::make_pair(key, Sensor())).first;
+            it->second.name = name;
+        }
+        Sensor& sensor = it->second;
+        advance(sensor, slice_number(now));
+        sensor.slices[sensor.current_slice % HISTOGRAM_COUNT].add(value);
+    }
+
+    // Calls function(name, count, p50, p95, p99) for each sensor with
+    // values in the window
+    template <typename Function>
+    void for_each(clock::time_point now, Function function)
+    {
+        uint64_t current = slice_number(now);
+        LogHistogram window;
+        for (auto& entry : sensors) {
+            Sensor& sensor = entry.second;
+            advance(sensor, current);
+            window.clear();
+            for (const LogHistogram& slice : sensor.slices) {
+                window.merge(slice);
+            }
+            if (window.count() == 0) {
+                continue;
+            }
+            function(
+                    sensor.name,
+                    window.count(),
+                    window.quantile(0.50),
+                    window.quantile(0.95),
+                    window.quantile(0.99));
+        }
+    }
+
+    // Forgets a sensor, for example when its instance is disposed
+    void remove(const Key& key)
+    {
+        sensors.erase(key);
+    }
+
+    unsigned int window() const
+    {
+        return window_sec;
+    }
+
+private:
+    struct Sensor {
+        Sensor() : current_slice(0)
+        {
+        }
+
+        std::string name;
+        uint64_t current_slice;
+        LogHistogram slices[HISTOGRAM_COUNT];
+    };
+
+    uint64_t slice_number(clock::time_point now) const
+    {
+        return static_cast<uint64_t>((now - start_time) / slice_duration);
+    }
+
+    // Clears the slices that are no longer in the window
+    static void advance(Sensor& sensor, uint64_t current)
+    {
+        uint64_t cleared = 0;
+        while (sensor.current_slice < current && cleared < HISTOGRAM_COUNT) {
+            sensor.current_slice++;
+            cleared++;
+            sensor.slices[sensor.current_slice % HISTOGRAM_COUNT].clear();
+        }
+        if (current > sensor.current_slice) {
+            sensor.current_slice = current;
+        }
+    }
+
+    clock::duration slice_duration;
+    unsigned int window_sec;
+    clock::time_point start_time;
+    // Ordered by key: the DDS InstanceHandle of the sensor
+    std::map<Key, Sensor> sensors;
+};
+
+#endif  // ROLLING_QUANTILES_HPP
@@ -0,0 +1,639 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef SAMPLE_RECORDING_HPP
+#define SAMPLE_RECORDING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Recording of the samples of the chocolate factory Topics, to analyze an
+// incident afterwards.
+//
+// A recording is a directory of segment files, segment_000001.rec and so
+// on. A segment is preallocated at its full size and memory-mapped, so
+// recording a sample is a copy to memory: its cost does not depend on the
+// disk, which the operating system writes to in the background. When a
+// segment is full the recording continues in the next one, which a
+// background thread has already created and mapped. That thread also
+// flushes and unmaps the full segments, so the recording thread never waits
+// for a file operation unless the disk falls behind the whole segment size.
+//
+// Segment layout, in the byte order of the host:
+// - SegmentHeader
+// - IndexEntry[index_capacity], one per record in order: the reception time
+//   and offset of each record, to find the records of a time range
+// - the records: a RecordHeader with the SampleInfo of the sample, then its
+//   serialized (CDR) data, padded to 8 bytes
+//
+// The record count in the header is updated after a record and its index
+// entry are complete. A segment cut short by a crash holds the records
+// counted.
+//
+// SegmentReader maps a segment back, to read its records in order or those
+// of a time range through the index.
+//
+// Memory-mapped files are only supported on POSIX systems.
+namespace recording {
+
+enum class Topic : uint8_t {
+    temperature = 1,
+    lot_state = 2
+};
+
+enum class InstanceState : uint8_t {
+    alive = 0,
+    disposed = 1,
+    no_writers = 2
+};
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t segment_number;
+    uint32_t index_capacity;
+    uint64_t segment_size;
+    // Records complete, and the offset of the end of the last one
+    uint32_t record_count;
+    uint32_t reserved;
+    uint64_t data_end;
+    uint64_t padding[3];
+};
+
+struct IndexEntry {
+    int64_t reception_timestamp_ns;
+    uint32_t offset;
+    uint8_t topic;
+    uint8_t reserved[3];
+};
+
+struct RecordHeader {
+    // Size of the serialized data that follows. 0 for a sample without
+    // valid data, which only notifies a change of the instance state.
+    uint32_t payload_size;
+    uint8_t topic;
+    uint8_t valid_data;
+    uint8_t instance_state;
+    uint8_t reserved;
+    int64_t source_timestamp_ns;
+    int64_t reception_timestamp_ns;
+    // Virtual GUID of the DataWriter that wrote the sample
+    uint8_t writer_guid[16];
+    // Key hash of the instance
+    uint8_t instance_handle[16];
+};
+
+// Smallest segment accepted: larger than any sample of the factory Topics
+const size_t MIN_SEGMENT_SIZE = 1024 * 1024;
+
+// Segments are addressed with 32-bit offsets
+const size_t MAX_SEGMENT_SIZE = 0xFFFFFFF8u;
+
+// One index entry per this many bytes of segment: the size of a Temperature
+// or ChocolateLotState record and its index entry. Segments of smaller
+// records fill their index first, those of larger records their data.
+const size_t SEGMENT_BYTES_PER_RECORD = 96;
+
+// Identifies the file format
+inline const char *segment_magic()
+{
+    return "FACREC01";
+}
+
+inline size_t padded_size(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+inline std::string segment_file_name(uint32_t number)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "segment_%06u.rec", number);
+    return name;
+}
+
+inline std::string segment_path(const std::string& directory, uint32_t number)
+{
+    return directory + "/" + segment_file_name(number);
+}
+
+inline std::string error_message(
+        const std::string& operation,
+        const std::string& path)
+{
+    return "Recording " + path + ": " + operation + " failed: "
+            + std::strerror(errno);
+}
+
+// Returns the numbers of the segments in a recording directory, in order.
+// Returns none if the directory does not exist.
+inline std::vector<uint32_t> list_segments(const std::string& directory)
+{
+    std::vector<uint32_t> numbers;
+#ifndef _WIN32
+    DIR *dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        return numbers;
+    }
+    while (struct dirent *entry = ::readdir(dir)) {
+        unsigned int number = 0;
+        if (std::sscanf(entry->d_name, "segment_%u", &number) == 1
+            && entry->d_name == segment_file_name(number)) {
+            numbers.push_back(number);
+        }
+    }
+    ::closedir(dir);
+    std::sort(numbers.begin(), numbers.end());
+#else
+    (void) directory;
+#endif
+    return numbers;
+}
+
+// A segment file, mapped for writing
+class SegmentWriter {
+public:
+    // Creates the file, preallocated and mapped. Throws std::runtime_error
+    // on failure.
+    SegmentWriter(const std::string& path, uint32_t number, size_t size)
+            : path(path),
+              size(size),
+              data(nullptr),
+              header(nullptr),
+              index(nullptr),
+              record_count(0),
+              data_end(0),
+              remove_file(false)
+    {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error(error_message("open", path));
+        }
+        // Reserve the disk blocks now: writing to a mapped page the disk
+        // has no room for would stop the application with SIGBUS
+        bool allocated = false;
+    #ifdef __linux__
+        allocated = ::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+    #endif
+        if (!allocated && ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            ::unlink(path.c_str());
+            throw std::runtime_error(error_message("ftruncate", path));
+        }
+        int flags = MAP_SHARED;
+    #ifdef MAP_POPULATE
+        // Map every page now, rather than on the first write to each
+        flags |= MAP_POPULATE;
+    #endif
+        void *address =
+                ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+        // The mapping stays valid after the file is closed
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            ::unlink(path.c_str());
+            throw std::runtime_error(error_message("mmap", path));
+        }
+        data = static_cast<unsigned char *>(address);
+
+        // The new file is filled with zeros
+        uint32_t index_capacity =
+                static_cast<uint32_t>(size / SEGMENT_BYTES_PER_RECORD);
+        header = reinterpret_cast<SegmentHeader *>(data);
+        std::memcpy(header->magic, segment_magic(), sizeof(header->magic));
+        header->segment_number = number;
+        header->index_capacity = index_capacity;
+        header->segment_size = size;
+        index = reinterpret_cast<IndexEntry *>(header + 1);
+        data_end = padded_size(
+                sizeof(SegmentHeader) + index_capacity * sizeof(IndexEntry));
+        header->data_end = data_end;
+#else
+        (void) number;
+        throw std::runtime_error(
+                "Recordings need memory-mapped files, which are not "
+                "supported on this platform: " + path);
+#endif
+    }
+
+    ~SegmentWriter()
+    {
+#ifndef _WIN32
+        if (data != nullptr) {
+            // Schedule the write to disk without waiting for it
+            ::msync(data, size, MS_ASYNC);
+            ::munmap(data, size);
+        }
+        if (remove_file) {
+            ::unlink(path.c_str());
+        }
+#endif
+    }
+
+    SegmentWriter(const SegmentWriter&) = delete;
+    SegmentWriter& operator=(const SegmentWriter&) = delete;
+
+    // Appends a record. Returns false, without writing, when the segment is
+    // full.
+    bool append(const RecordHeader& record, const void *payload)
+    {
+        size_t record_size =
+                sizeof(RecordHeader) + padded_size(record.payload_size);
+        if (record_count == header->index_capacity
+            || data_end + record_size > size) {
+            return false;
+        }
+        unsigned char *destination = data + data_end;
+        std::memcpy(destination, &record, sizeof(RecordHeader));
+        if (record.payload_size > 0) {
+            std::memcpy(
+                    destination + sizeof(RecordHeader),
+                    payload,
+                    record.payload_size);
+        }
+        IndexEntry& entry = index[record_count];
+        entry.reception_timestamp_ns = record.reception_timestamp_ns;
+        entry.offset = static_cast<uint32_t>(data_end);
+        entry.topic = record.topic;
+
+        data_end += record_size;
+        record_count++;
+        // A reader of the file sees a record once it is complete
+        std::atomic_thread_fence(std::memory_order_release);
+        header->data_end = data_end;
+        header->record_count = record_count;
+        return true;
+    }
+
+    uint32_t count() const
+    {
+        return record_count;
+    }
+
+    // Deletes the file when the segment is destroyed: for a segment that
+    // was prepared but not used
+    void remove_on_close()
+    {
+        remove_file = true;
+    }
+
+private:
+    std::string path;
+    size_t size;
+    unsigned char *data;
+    SegmentHeader *header;
+    IndexEntry *index;
+    uint32_t record_count;
+    uint64_t data_end;
+    bool remove_file;
+};
+
+// A segment file, mapped for reading. It holds the records counted when it
+// was opened: a segment still being recorded can be read too.
+class SegmentReader {
+public:
+    // Maps the file and checks its header and index. Throws
+    // std::runtime_error if it is not a valid segment.
+    explicit SegmentReader(const std::string& path)
+            : path(path),
+              size(0),
+              data(nullptr),
+              header(nullptr),
+              index(nullptr),
+              record_count(0)
+    {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(error_message("open", path));
+        }
+        struct stat file_status;
+        if (::fstat(fd, &file_status) != 0) {
+            ::close(fd);
+            throw std::runtime_error(error_message("fstat", path));
+        }
+        size = static_cast<size_t>(file_status.st_size);
+        if (size < sizeof(SegmentHeader)) {
+            ::close(fd);
+            throw std::runtime_error(
+                    "Recording " + path + ": not a segment, too short");
+        }
+        void *address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            throw std::runtime_error(error_message("mmap", path));
+        }
+        data = static_cast<const unsigned char *>(address);
+        header = reinterpret_cast<const SegmentHeader *>(data);
+        index = reinterpret_cast<const IndexEntry *>(header + 1);
+        record_count = header->record_count;
+        // The records counted are complete
+        std::atomic_thread_fence(std::memory_order_acquire);
+        check();
+#else
+        throw std::runtime_error(
+                "Recordings need memory-mapped files, which are not "
+                "supported on this platform: " + path);
+#endif
+    }
+
+    ~SegmentReader()
+    {
+#ifndef _WIN32
+        if (data != nullptr) {
+            ::munmap(const_cast<unsigned char *>(data), size);
+        }
+#endif
+    }
+
+    SegmentReader(const SegmentReader&) = delete;
+    SegmentReader& operator=(const SegmentReader&) = delete;
+
+    uint32_t number() const
+    {
+        return header->segment_number;
+    }
+
+    uint32_t count() const
+    {
+        return record_count;
+    }
+
+    const IndexEntry& entry(uint32_t position) const
+    {
+        return index[position];
+    }
+
+    // The record at a position, in the order they were recorded
+    const RecordHeader& record(uint32_t position) const
+    {
+        return *reinterpret_cast<const RecordHeader *>(
+                data + index[position].offset);
+    }
+
+    // The serialized data of the record at a position
+    const unsigned char *payload(uint32_t position) const
+    {
+        return data + index[position].offset + sizeof(RecordHeader);
+    }
+
+private:
+    // Checks that the header, the index and every record counted are
+    // within the file, so that reading them needs no more checks
+    void check()
+    {
+        std::string problem;
+        uint64_t index_end = sizeof(SegmentHeader)
+                + static_cast<uint64_t>(header->index_capacity)
+                        * sizeof(IndexEntry);
+        if (std::memcmp(header->magic, segment_magic(), sizeof(header->magic))
+            != 0) {
+            problem = "not a segment";
+        } else if (header->segment_size != size) {
+            problem = "size does not match the header";
+        } else if (
+                record_count > header->index_capacity
+                || index_end > size || header->data_end > size) {
+            problem = "index out of the file";
+        }
+        for (uint32_t position = 0; problem.empty() && position < record_count;
+             position++) {
+            uint64_t offset = index[position].offset;
+            if (offset < index_end
+                || offset + sizeof(RecordHeader) > header->data_end
+                || offset + sizeof(RecordHeader)
+                                + record(position).payload_size
+                        > header->data_end) {
+                problem = "record " + std::to_string(position)
+                        + " out of the file";
+            }
+        }
+        if (!problem.empty()) {
+#ifndef _WIN32
+            ::munmap(const_cast<unsigned char *>(data), size);
+#endif
+            data = nullptr;
+            throw std::runtime_error("Recording " + path + ": " + problem);
+        }
+    }
+
+    std::string path;
+    size_t size;
+    const unsigned char *data;
+    const SegmentHeader *header;
+    const IndexEntry *index;
+    uint32_t record_count;
+};
+
+// Appends records to the segments of a recording directory. Records are
+// appended from one thread; a background thread prepares the next segment
+// and closes the full ones.
+class Recorder {
+public:
+    // Starts recording into the directory, creating it if needed. The
+    // segments follow those of the recordings already there. Throws
+    // std::runtime_error on failure.
+    Recorder(const std::string& directory, size_t segment_size)
+            : directory(directory),
+              segment_size(std::min(
+                      std::max(segment_size, MIN_SEGMENT_SIZE),
+                      MAX_SEGMENT_SIZE)
+                           & ~static_cast<size_t>(7)),
+              next_number(1),
+              record_count(0),
+              byte_count(0),
+              segment_count(1),
+              rollover_wait_count(0),
+              stopping(false)
+    {
+#ifndef _WIN32
+        if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error(error_message("mkdir", directory));
+        }
+#endif
+        std::vector<uint32_t> existing = list_segments(directory);
+        if (!existing.empty()) {
+            next_number = existing.back() + 1;
+        }
+        current = create_segment();
+        preparer = std::thread(&Recorder::prepare_segments, this);
+    }
+
+    ~Recorder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            full_segments.push_back(std::move(current));
+            stopping = true;
+        }
+        changed.notify_all();
+        preparer.join();
+        // The segment prepared last was not used
+        if (next) {
+            next->remove_on_close();
+        }
+    }
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // Appends a record with payload_size bytes of serialized data. Throws
+    // std::runtime_error if the next segment cannot be created, or if the
+    // record is larger than a segment.
+    void record(RecordHeader& header, const void *payload, size_t payload_size)
+    {
+        header.payload_size = static_cast<uint32_t>(payload_size);
+        if (!current->append(header, payload)) {
+            next_segment();
+            if (!current->append(header, payload)) {
+                throw std::runtime_error(
+                        "Recording " + directory + ": a record of "
+                        + std::to_string(payload_size)
+                        + " bytes does not fit in a segment");
+            }
+        }
+        record_count++;
+        byte_count += sizeof(RecordHeader) + padded_size(payload_size);
+    }
+
+    uint64_t records() const
+    {
+        return record_count;
+    }
+
+    uint64_t bytes() const
+    {
+        return byte_count;
+    }
+
+    // Segments started, including the current one
+    uint64_t segments() const
+    {
+        return segment_count;
+    }
+
+    // Times the recording had to wait for the next segment to be ready
+    uint64_t rollover_waits() const
+    {
+        return rollover_wait_count;
+    }
+
+private:
+    std::unique_ptr<SegmentWriter> create_segment()
+    {
+        uint32_t number = next_number++;
+        std::unique_ptr<SegmentWriter> segment(new SegmentWriter(
+                segment_path(directory, number),
+                number,
+                segment_size));
+        return segment;
+    }
+
+    // Continues in the prepared segment, and hands the full one to the
+    // background thread
+    void next_segment()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        full_segments.push_back(std::move(current));
+        if (!next && error.empty()) {
+            rollover_wait_count++;
+        }
+        changed.notify_all();
+        changed.wait(lock, [this]() { return next || !error.empty(); });
+        if (!next) {
+            throw std::runtime_error(error);
+        }
+        current = std::move(next);
+        segment_count++;
+        changed.notify_all();
+    }
+
+    void prepare_segments()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() {
+                return stopping || !full_segments.empty()
+                        || (!next && error.empty());
+            });
+            std::vector<std::unique_ptr<SegmentWriter>> closing;
+            closing.swap(full_segments);
+            bool prepare = !stopping && !next && error.empty();
+            lock.unlock();
+
+            // Flushes and unmaps the full segments
+            closing.clear();
+            std::unique_ptr<SegmentWriter> prepared;
+            std::string prepare_error;
+            if (prepare) {
+                try {
+                    prepared = create_segment();
+                } catch (const std::exception& ex) {
+                    prepare_error = ex.what();
+                }
+            }
+
+            lock.lock();
+            if (prepare) {
+                next = std::move(prepared);
+                error = prepare_error;
+                changed.notify_all();
+            }
+            if (stopping && full_segments.empty()) {
+                break;
+            }
+        }
+    }
+
+    std::string directory;
+    size_t segment_size;
+    // Only used by the thread that creates the segments: the constructor,
+    // then the background thread
+    uint32_t next_number;
+    std::unique_ptr<SegmentWriter> current;
+    uint64_t record_count;
+    uint64_t byte_count;
+    uint64_t segment_count;
+    uint64_t rollover_wait_count;
+
+    // Shared with the background thread
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::unique_ptr<SegmentWriter> next;
+    std::vector<std::unique_ptr<SegmentWriter>> full_segments;
+    std::string error;
+    bool stopping;
+    std::thread preparer;
+};
+
+}  // namespace recording
+
+#endif  // SAMPLE_RECORDING_HPP
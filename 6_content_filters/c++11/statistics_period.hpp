@@ -0,0 +1,65 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef STATISTICS_PERIOD_HPP
+#define STATISTICS_PERIOD_HPP
+
+#include <chrono>
+
+#include <dds/core/ddscore.hpp>
+
+// Tells the main loop of an application when to print the statistics, or
+// run another periodic task: once every period, in seconds or milliseconds.
+// A period of 0 never runs it.
+class StatisticsPeriod {
+public:
+    explicit StatisticsPeriod(unsigned int period_sec)
+            : period(std::chrono::seconds(period_sec)),
+              next_time(std::chrono::steady_clock::now() + period)
+    {
+    }
+
+    explicit StatisticsPeriod(std::chrono::milliseconds period)
+            : period(period),
+              next_time(std::chrono::steady_clock::now() + period)
+    {
+    }
+
+    // Returns true when a period has elapsed since it last returned true
+    bool due()
+    {
+        if (period.count() == 0
+                || std::chrono::steady_clock::now() < next_time) {
+            return false;
+        }
+        next_time += period;
+        return true;
+    }
+
+    // Returns how long a WaitSet may wait without delaying the statistics:
+    // the period, or max_wait if the period is longer or 0
+    dds::core::Duration wait_time(const dds::core::Duration& max_wait) const
+    {
+        dds::core::Duration period_duration =
+                dds::core::Duration::from_millisecs(period.count());
+        if (period.count() == 0 || period_duration > max_wait) {
+            return max_wait;
+        }
+        return period_duration;
+    }
+
+private:
+    std::chrono::milliseconds period;
+    std::chrono::steady_clock::time_point next_time;
+};
+
+#endif  // STATISTICS_PERIOD_HPP
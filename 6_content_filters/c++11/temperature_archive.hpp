@@ -0,0 +1,990 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TEMPERATURE_ARCHIVE_HPP
+#define TEMPERATURE_ARCHIVE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "temperature_scan.hpp"
+
+// Archive of the temperature readings, stored by column to keep months of
+// history in little disk.
+//
+// An archive is a directory of files, archive_000001.tca and so on, one per
+// run of the archiver. A file is a FileHeader followed by blocks of up to
+// BLOCK_ROWS readings. Each block starts with a BlockHeader holding the
+// range of its timestamps and degrees, so that a query skips the blocks
+// that cannot match without decoding them. Then come its columns:
+// - the sensor_ids of the block, once each, then the index of each reading's
+//   sensor_id in that dictionary, bit-packed
+// - the timestamps in microseconds: the first timestamp and delta are in
+//   the header, then the delta of the deltas, zigzag-coded so that small
+//   negative values stay small, and bit-packed. Readings at a steady rate
+//   take a few bits each.
+// - the degrees, minus the lowest of the block, bit-packed
+//
+// Each column is bit-packed with the fewest bits that hold its largest value
+// in the block. A block is written at once when it is full: a file cut
+// short by a crash holds the blocks written until then.
+//
+// Queries map the files and scan the blocks in parallel, one thread per
+// core. Memory-mapped files are only supported on POSIX systems.
+namespace temperature_archive {
+
+// Readings per block
+const uint32_t BLOCK_ROWS = 8192;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t file_number;
+    uint32_t reserved;
+};
+
+struct BlockHeader {
+    char magic[4];
+    // Size of the block, header included
+    uint32_t block_size;
+    uint32_t row_count;
+    uint32_t sensor_count;
+    // Range of the timestamps and degrees of the readings of the block
+    int64_t min_timestamp_us;
+    int64_t max_timestamp_us;
+    int32_t min_degrees;
+    int32_t max_degrees;
+    // Timestamp of the first reading, and delta from it to the second
+    int64_t first_timestamp_us;
+    int64_t first_delta_us;
+    // Size of the dictionary, in bytes
+    uint32_t dictionary_size;
+    // Bits per value of each column
+    uint8_t sensor_bits;
+    uint8_t timestamp_bits;
+    uint8_t degrees_bits;
+    uint8_t reserved;
+};
+
+// Identifies the file format
+inline const char *file_magic()
+{
+    return "FACTCA01";
+}
+
+inline const char *block_magic()
+{
+    return "TBLK";
+}
+
+inline uint64_t zigzag_encode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1)
+            ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzag_decode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1)
+            ^ -static_cast<int64_t>(value & 1);
+}
+
+// Bits needed for a value: 0 for 0
+inline unsigned int bit_width(uint64_t value)
+{
+    unsigned int width = 0;
+    while (value != 0) {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+inline size_t packed_words(size_t count, unsigned int width)
+{
+    return (count * width + 63) / 64;
+}
+
+// Packs count values of width bits (0 to 64) each into words, from the
+// lowest bit
+inline void pack_bits(
+        const uint64_t *values,
+        size_t count,
+        unsigned int width,
+        uint64_t *words)
+{
+    std::fill(words, words + packed_words(count, width), 0);
+    if (width == 0) {
+        return;
+    }
+    size_t bit = 0;
+    for (size_t i = 0; i < count; i++, bit += width) {
+        size_t word = bit / 64;
+        unsigned int shift = bit % 64;
+        words[word] |= values[i] << shift;
+        if (shift + width > 64) {
+            words[word + 1] |= values[i] >> (64 - shift);
+        }
+    }
+}
+
+inline void unpack_bits(
+        const uint64_t *words,
+        size_t count,
+        unsigned int width,
+        uint64_t *values)
+{
+    if (width == 0) {
+        std::fill(values, values + count, 0);
+        return;
+    }
+    uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    size_t last_word = packed_words(count, width) - 1;
+    size_t bit = 0;
+    size_t i = 0;
+    // While there is a next word, the high bits of a value are taken from it
+    // without a branch: shifted in two steps, which shift it out entirely
+    // when the value does not reach it
+    for (; i < count && bit / 64 < last_word; i++, bit += width) {
+        size_t word = bit / 64;
+        unsigned int shift = bit % 64;
+        values[i] = ((words[word] >> shift)
+                     | ((words[word + 1] << 1) << (63 - shift)))
+                & mask;
+    }
+    for (; i < count; i++, bit += width) {
+        values[i] = (words[bit / 64] >> (bit % 64)) & mask;
+    }
+}
+
+inline size_t padded_size(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// Size of a block with these columns, or 0 if it does not fit in 32 bits
+inline uint64_t block_size_for(
+        uint32_t row_count,
+        uint32_t dictionary_size,
+        unsigned int sensor_bits,
+        unsigned int timestamp_bits,
+        unsigned int degrees_bits)
+{
+    uint64_t delta_count = row_count > 2 ? row_count - 2 : 0;
+    uint64_t size = sizeof(BlockHeader) + padded_size(dictionary_size)
+            + 8
+                    * (packed_words(row_count, sensor_bits)
+                       + packed_words(delta_count, timestamp_bits)
+                       + packed_words(row_count, degrees_bits));
+    return size <= 0xFFFFFFFFu ? size : 0;
+}
+
+inline std::string archive_file_name(uint32_t number)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "archive_%06u.tca", number);
+    return name;
+}
+
+inline std::string archive_path(const std::string& directory, uint32_t number)
+{
+    return directory + "/" + archive_file_name(number);
+}
+
+inline std::string error_message(
+        const std::string& operation,
+        const std::string& path)
+{
+    return "Archive " + path + ": " + operation + " failed: "
+            + std::strerror(errno);
+}
+
+// Returns the numbers of the files of an archive directory, in order.
+// Returns none if the directory does not exist.
+inline std::vector<uint32_t> list_archive_files(const std::string& directory)
+{
+    std::vector<uint32_t> numbers;
+#ifndef _WIN32
+    DIR *dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        return numbers;
+    }
+    while (struct dirent *entry = ::readdir(dir)) {
+        unsigned int number = 0;
+        if (std::sscanf(entry->d_name, "archive_%u", &number) == 1
+            && entry->d_name == archive_file_name(number)) {
+            numbers.push_back(number);
+        }
+    }
+    ::closedir(dir);
+    std::sort(numbers.begin(), numbers.end());
+#else
+    (void) directory;
+#endif
+    return numbers;
+}
+
+// Accumulates the readings of a block, and encodes them by column
+class BlockEncoder {
+public:
+    BlockEncoder()
+    {
+        timestamps.reserve(BLOCK_ROWS);
+        sensor_codes.reserve(BLOCK_ROWS);
+        degrees.reserve(BLOCK_ROWS);
+        deltas.reserve(BLOCK_ROWS);
+        values.reserve(BLOCK_ROWS);
+    }
+
+    void add(int64_t timestamp_us, const std::string& sensor_id, int32_t value)
+    {
+        auto code = dictionary.find(sensor_id);
+        if (code == dictionary.end()) {
+            // Sensor ids are bounded strings: the length fits in 16 bits
+            code = dictionary
+                           .emplace(
+                                   sensor_id.substr(0, 0xFFFF),
+                                   static_cast<uint32_t>(sensor_ids.size()))
+                           .first;
+            sensor_ids.push_back(code->first);
+        }
+        timestamps.push_back(timestamp_us);
+        sensor_codes.push_back(code->second);
+        degrees.push_back(value);
+    }
+
+    uint32_t size() const
+    {
+        return static_cast<uint32_t>(timestamps.size());
+    }
+
+    // Appends the block of the readings added to out, and starts a new one.
+    // Throws std::runtime_error if the block does not fit in 32 bits.
+    void encode(std::vector<unsigned char>& out)
+    {
+        uint32_t row_count = size();
+        if (row_count == 0) {
+            return;
+        }
+        BlockHeader header = {};
+        std::memcpy(header.magic, block_magic(), sizeof(header.magic));
+        header.row_count = row_count;
+        header.sensor_count = static_cast<uint32_t>(sensor_ids.size());
+        header.min_timestamp_us = *std::min_element(
+                timestamps.begin(),
+                timestamps.end());
+        header.max_timestamp_us = *std::max_element(
+                timestamps.begin(),
+                timestamps.end());
+        header.min_degrees = *std::min_element(degrees.begin(), degrees.end());
+        header.max_degrees = *std::max_element(degrees.begin(), degrees.end());
+        header.first_timestamp_us = timestamps[0];
+        header.first_delta_us =
+                row_count > 1 ? timestamps[1] - timestamps[0] : 0;
+        for (const std::string& sensor_id : sensor_ids) {
+            header.dictionary_size += static_cast<uint32_t>(
+                    sizeof(uint16_t) + sensor_id.size());
+        }
+        header.sensor_bits = static_cast<uint8_t>(
+                bit_width(sensor_ids.size() - 1));
+
+        // Delta of the deltas of the timestamps, from the third one
+        deltas.clear();
+        uint64_t largest = 0;
+        for (uint32_t i = 2; i < row_count; i++) {
+            int64_t delta = timestamps[i] - timestamps[i - 1];
+            int64_t previous_delta = timestamps[i - 1] - timestamps[i - 2];
+            deltas.push_back(zigzag_encode(delta - previous_delta));
+            largest |= deltas.back();
+        }
+        header.timestamp_bits = static_cast<uint8_t>(bit_width(largest));
+        header.degrees_bits = static_cast<uint8_t>(bit_width(
+                static_cast<uint64_t>(
+                        static_cast<int64_t>(header.max_degrees)
+                        - header.min_degrees)));
+        uint64_t block_size = block_size_for(
+                row_count,
+                header.dictionary_size,
+                header.sensor_bits,
+                header.timestamp_bits,
+                header.degrees_bits);
+        if (block_size == 0) {
+            throw std::runtime_error("Archive block too large");
+        }
+        header.block_size = static_cast<uint32_t>(block_size);
+
+        size_t begin = out.size();
+        out.resize(begin + block_size, 0);
+        unsigned char *position = out.data() + begin;
+        std::memcpy(position, &header, sizeof(header));
+        position += sizeof(header);
+        unsigned char *dictionary_begin = position;
+        for (const std::string& sensor_id : sensor_ids) {
+            uint16_t length = static_cast<uint16_t>(sensor_id.size());
+            std::memcpy(position, &length, sizeof(length));
+            std::memcpy(position + sizeof(length), sensor_id.data(), length);
+            position += sizeof(length) + length;
+        }
+        position = dictionary_begin + padded_size(header.dictionary_size);
+
+        // The block starts 8-byte aligned in out, and so do its columns
+        uint64_t *words = reinterpret_cast<uint64_t *>(position);
+        values.assign(sensor_codes.begin(), sensor_codes.end());
+        pack_bits(values.data(), row_count, header.sensor_bits, words);
+        words += packed_words(row_count, header.sensor_bits);
+        pack_bits(deltas.data(), deltas.size(), header.timestamp_bits, words);
+        words += packed_words(deltas.size(), header.timestamp_bits);
+        for (uint32_t i = 0; i < row_count; i++) {
+            values[i] = static_cast<uint64_t>(
+                    static_cast<int64_t>(degrees[i]) - header.min_degrees);
+        }
+        pack_bits(values.data(), row_count, header.degrees_bits, words);
+
+        timestamps.clear();
+        sensor_codes.clear();
+        degrees.clear();
+        dictionary.clear();
+        sensor_ids.clear();
+    }
+
+private:
+    std::vector<int64_t> timestamps;
+    std::vector<uint32_t> sensor_codes;
+    std::vector<int32_t> degrees;
+    // Index of each sensor_id in the dictionary of the block
+    std::unordered_map<std::string, uint32_t> dictionary;
+    std::vector<std::string> sensor_ids;
+    // Columns being packed
+    std::vector<uint64_t> deltas;
+    std::vector<uint64_t> values;
+};
+
+// Appends the readings to a new file of an archive directory
+class ArchiveWriter {
+public:
+    // Creates the directory if needed, and a file that follows those already
+    // there. Throws std::runtime_error on failure.
+    explicit ArchiveWriter(const std::string& directory)
+            : file(nullptr),
+              reading_count(0),
+              block_count(0),
+              byte_count(sizeof(FileHeader))
+    {
+#ifndef _WIN32
+        if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+            throw std::runtime_error(error_message("mkdir", directory));
+        }
+#endif
+        std::vector<uint32_t> existing = list_archive_files(directory);
+        uint32_t number = existing.empty() ? 1 : existing.back() + 1;
+        path = archive_path(directory, number);
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error(error_message("open", path));
+        }
+        FileHeader header = {};
+        std::memcpy(header.magic, file_magic(), sizeof(header.magic));
+        header.file_number = number;
+        write(&header, sizeof(header));
+    }
+
+    // Writes the last block
+    ~ArchiveWriter()
+    {
+        try {
+            flush();
+        } catch (const std::exception&) {
+            // Nothing else can be done in a destructor
+        }
+        std::fclose(file);
+    }
+
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    // Adds a reading, and writes the block when it is full. Throws
+    // std::runtime_error if the file cannot be written.
+    void add(
+            int64_t timestamp_us,
+            const std::string& sensor_id,
+            int32_t degrees)
+    {
+        encoder.add(timestamp_us, sensor_id, degrees);
+        reading_count++;
+        if (encoder.size() == BLOCK_ROWS) {
+            flush();
+        }
+    }
+
+    // Writes the readings added so far as a block, even if it is not full
+    void flush()
+    {
+        if (encoder.size() == 0) {
+            return;
+        }
+        block.clear();
+        encoder.encode(block);
+        write(block.data(), block.size());
+        block_count++;
+        byte_count += block.size();
+    }
+
+    // Readings not written yet
+    uint32_t pending() const
+    {
+        return encoder.size();
+    }
+
+    const std::string& file_path() const
+    {
+        return path;
+    }
+
+    uint64_t readings() const
+    {
+        return reading_count;
+    }
+
+    uint64_t blocks() const
+    {
+        return block_count;
+    }
+
+    uint64_t bytes() const
+    {
+        return byte_count;
+    }
+
+private:
+    void write(const void *data, size_t size)
+    {
+        if (std::fwrite(data, 1, size, file) != size
+            || std::fflush(file) != 0) {
+            throw std::runtime_error(error_message("write", path));
+        }
+    }
+
+    std::string path;
+    std::FILE *file;
+    BlockEncoder encoder;
+    std::vector<unsigned char> block;
+    uint64_t reading_count;
+    uint64_t block_count;
+    uint64_t byte_count;
+};
+
+// A reading found by a query. The sensor_id points into the mapped file.
+struct Reading {
+    int64_t timestamp_us;
+    const char *sensor_id;
+    uint16_t sensor_id_length;
+    int32_t degrees;
+
+    std::string sensor() const
+    {
+        return std::string(sensor_id, sensor_id_length);
+    }
+};
+
+// Readings of a sensor in a time range, or above some degrees in a time
+// range. The times are inclusive.
+struct Query {
+    Query()
+            : from_us((std::numeric_limits<int64_t>::min)()),
+              to_us((std::numeric_limits<int64_t>::max)()),
+              by_sensor(false),
+              above(false),
+              above_degrees(0)
+    {
+    }
+
+    int64_t from_us;
+    int64_t to_us;
+    bool by_sensor;
+    std::string sensor_id;
+    bool above;
+    int32_t above_degrees;
+};
+
+inline bool parse_time_us(const std::string& text, int64_t& time_us)
+{
+    char *end = nullptr;
+    double seconds = std::strtod(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !(seconds > -9.2e12)
+        || !(seconds < 9.2e12)) {
+        return false;
+    }
+    time_us = static_cast<int64_t>(seconds * 1000000);
+    return true;
+}
+
+// Parses "sensor <sensor_id> <from> <to>" or "above <degrees> [<from> <to>]",
+// with the times in seconds since the epoch. Returns false if the text is not
+// a query.
+inline bool parse_query(const std::string& text, Query& query)
+{
+    std::istringstream words(text);
+    std::string kind;
+    std::string value;
+    std::string from;
+    std::string to;
+    std::string extra;
+    words >> kind >> value >> from >> to >> extra;
+    query = Query();
+    if (value.empty() || !extra.empty() || from.empty() != to.empty()) {
+        return false;
+    }
+    if (!from.empty()
+        && (!parse_time_us(from, query.from_us)
+            || !parse_time_us(to, query.to_us))) {
+        return false;
+    }
+    if (kind == "sensor") {
+        query.by_sensor = true;
+        query.sensor_id = value;
+        return !from.empty();
+    } else if (kind == "above") {
+        char *end = nullptr;
+        long degrees = std::strtol(value.c_str(), &end, 10);
+        if (*end != '\0' || degrees < (std::numeric_limits<int32_t>::min)()
+            || degrees > (std::numeric_limits<int32_t>::max)()) {
+            return false;
+        }
+        query.above = true;
+        query.above_degrees = static_cast<int32_t>(degrees);
+        return true;
+    }
+    return false;
+}
+
+// A file of an archive, mapped for reading
+class ArchiveFile {
+public:
+    // Maps the file and finds its blocks. A block cut short at the end of
+    // the file is ignored. Throws std::runtime_error if it is not an archive
+    // file.
+    explicit ArchiveFile(const std::string& path)
+            : path(path), size(0), data(nullptr), truncated(false)
+    {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(error_message("open", path));
+        }
+        struct stat file_status;
+        if (::fstat(fd, &file_status) != 0) {
+            ::close(fd);
+            throw std::runtime_error(error_message("fstat", path));
+        }
+        size = static_cast<size_t>(file_status.st_size);
+        if (size < sizeof(FileHeader)) {
+            ::close(fd);
+            throw std::runtime_error(
+                    "Archive " + path + ": not an archive, too short");
+        }
+        void *address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (address == MAP_FAILED) {
+            throw std::runtime_error(error_message("mmap", path));
+        }
+        data = static_cast<const unsigned char *>(address);
+        if (std::memcmp(data, file_magic(), sizeof(FileHeader::magic)) != 0) {
+            ::munmap(const_cast<unsigned char *>(data), size);
+            data = nullptr;
+            throw std::runtime_error("Archive " + path + ": not an archive");
+        }
+        find_blocks();
+#else
+        throw std::runtime_error(
+                "Archives need memory-mapped files, which are not supported "
+                "on this platform: " + path);
+#endif
+    }
+
+    ~ArchiveFile()
+    {
+#ifndef _WIN32
+        if (data != nullptr) {
+            ::munmap(const_cast<unsigned char *>(data), size);
+        }
+#endif
+    }
+
+    ArchiveFile(const ArchiveFile&) = delete;
+    ArchiveFile& operator=(const ArchiveFile&) = delete;
+
+    // The complete blocks, in order
+    const std::vector<const BlockHeader *>& blocks() const
+    {
+        return block_headers;
+    }
+
+    // True if the file ends with an incomplete block
+    bool incomplete() const
+    {
+        return truncated;
+    }
+
+private:
+    // Walks the blocks, checking that the columns of each fit in it, so
+    // that decoding them needs no more checks
+    void find_blocks()
+    {
+        size_t offset = sizeof(FileHeader);
+        while (offset + sizeof(BlockHeader) <= size) {
+            const BlockHeader *header =
+                    reinterpret_cast<const BlockHeader *>(data + offset);
+            if (std::memcmp(header->magic, block_magic(), sizeof(header->magic))
+                        != 0
+                || header->block_size > size - offset
+                || header->row_count == 0 || header->row_count > BLOCK_ROWS
+                || header->sensor_count == 0
+                || header->sensor_count > header->row_count
+                || header->sensor_bits > 32 || header->timestamp_bits > 64
+                || header->degrees_bits > 32
+                || block_size_for(
+                           header->row_count,
+                           header->dictionary_size,
+                           header->sensor_bits,
+                           header->timestamp_bits,
+                           header->degrees_bits)
+                        != header->block_size
+                || !dictionary_valid(header)) {
+                break;
+            }
+            block_headers.push_back(header);
+            offset += header->block_size;
+        }
+        truncated = offset != size;
+    }
+
+    bool dictionary_valid(const BlockHeader *header) const
+    {
+        const unsigned char *position =
+                reinterpret_cast<const unsigned char *>(header + 1);
+        const unsigned char *end = position + header->dictionary_size;
+        for (uint32_t i = 0; i < header->sensor_count; i++) {
+            uint16_t length;
+            if (end - position < static_cast<ptrdiff_t>(sizeof(length))) {
+                return false;
+            }
+            std::memcpy(&length, position, sizeof(length));
+            position += sizeof(length);
+            if (end - position < length) {
+                return false;
+            }
+            position += length;
+        }
+        return position == end;
+    }
+
+    std::string path;
+    size_t size;
+    const unsigned char *data;
+    std::vector<const BlockHeader *> block_headers;
+    bool truncated;
+};
+
+// Decodes the blocks of a query. One per thread: its buffers are reused for
+// every block.
+class BlockScanner {
+public:
+    BlockScanner()
+            : timestamps(BLOCK_ROWS),
+              sensor_codes(BLOCK_ROWS),
+              values(BLOCK_ROWS),
+              degrees(BLOCK_ROWS),
+              sensor_code(0)
+    {
+    }
+
+    // True if the block may hold readings of the query, from its header and
+    // dictionary
+    bool may_match(const BlockHeader& header, const Query& query)
+    {
+        if (header.max_timestamp_us < query.from_us
+            || header.min_timestamp_us > query.to_us) {
+            return false;
+        }
+        if (query.above && header.max_degrees <= query.above_degrees) {
+            return false;
+        }
+        read_dictionary(header);
+        if (query.by_sensor) {
+            sensor_code = find_sensor(query.sensor_id);
+            return sensor_code < sensors.size();
+        }
+        return true;
+    }
+
+    // Adds the readings of the block that match the query. may_match() must
+    // have returned true for the block.
+    void scan(
+            const BlockHeader& header,
+            const Query& query,
+            std::vector<Reading>& matches)
+    {
+        uint32_t row_count = header.row_count;
+        const uint64_t *words = reinterpret_cast<const uint64_t *>(
+                reinterpret_cast<const unsigned char *>(&header + 1)
+                + padded_size(header.dictionary_size));
+        unpack_bits(words, row_count, header.sensor_bits, sensor_codes.data());
+        words += packed_words(row_count, header.sensor_bits);
+        uint32_t delta_count = row_count > 2 ? row_count - 2 : 0;
+        unpack_bits(words, delta_count, header.timestamp_bits, values.data());
+        words += packed_words(delta_count, header.timestamp_bits);
+        decode_timestamps(header);
+        unpack_bits(words, row_count, header.degrees_bits, values.data());
+        for (uint32_t i = 0; i < row_count; i++) {
+            degrees[i] = static_cast<int32_t>(
+                    header.min_degrees + static_cast<int64_t>(values[i]));
+        }
+
+        // Readings above the degrees are found 64 at a time
+        using temperature_scan::BLOCK_SIZE;
+        for (uint32_t first = 0; first < row_count; first += BLOCK_SIZE) {
+            uint32_t count = std::min<uint32_t>(BLOCK_SIZE, row_count - first);
+            uint64_t candidates = count == 64
+                    ? ~uint64_t(0)
+                    : (uint64_t(1) << count) - 1;
+            if (query.above) {
+                temperature_scan::ScanStats stats;
+                candidates = temperature_scan::scan_block(
+                        degrees.data() + first,
+                        count,
+                        (std::numeric_limits<int32_t>::min)(),
+                        query.above_degrees,
+                        stats);
+            }
+            while (candidates != 0) {
+                uint32_t i = first
+                        + temperature_scan::lowest_bit_index(candidates);
+                candidates &= candidates - 1;
+                if (timestamps[i] < query.from_us || timestamps[i] > query.to_us
+                    || (query.by_sensor && sensor_codes[i] != sensor_code)) {
+                    continue;
+                }
+                const Sensor& sensor = sensors[sensor_codes[i]];
+                matches.push_back({ timestamps[i],
+                                    sensor.id,
+                                    sensor.length,
+                                    degrees[i] });
+            }
+        }
+    }
+
+private:
+    struct Sensor {
+        const char *id;
+        uint16_t length;
+    };
+
+    void read_dictionary(const BlockHeader& header)
+    {
+        sensors.clear();
+        const unsigned char *position =
+                reinterpret_cast<const unsigned char *>(&header + 1);
+        for (uint32_t i = 0; i < header.sensor_count; i++) {
+            uint16_t length;
+            std::memcpy(&length, position, sizeof(length));
+            position += sizeof(length);
+            sensors.push_back(
+                    { reinterpret_cast<const char *>(position), length });
+            position += length;
+        }
+    }
+
+    uint64_t find_sensor(const std::string& sensor_id) const
+    {
+        for (uint64_t code = 0; code < sensors.size(); code++) {
+            if (sensors[code].length == sensor_id.size()
+                && std::memcmp(
+                           sensors[code].id,
+                           sensor_id.data(),
+                           sensor_id.size())
+                        == 0) {
+                return code;
+            }
+        }
+        return sensors.size();
+    }
+
+    // From the first timestamp and delta, and the delta of the deltas in
+    // values
+    void decode_timestamps(const BlockHeader& header)
+    {
+        timestamps[0] = header.first_timestamp_us;
+        if (header.row_count < 2) {
+            return;
+        }
+        int64_t delta = header.first_delta_us;
+        timestamps[1] = timestamps[0] + delta;
+        for (uint32_t i = 2; i < header.row_count; i++) {
+            delta += zigzag_decode(values[i - 2]);
+            timestamps[i] = timestamps[i - 1] + delta;
+        }
+    }
+
+    std::vector<int64_t> timestamps;
+    std::vector<uint64_t> sensor_codes;
+    std::vector<uint64_t> values;
+    std::vector<int32_t> degrees;
+    std::vector<Sensor> sensors;
+    uint64_t sensor_code;
+};
+
+// Blocks considered by a query
+struct QueryStatistics {
+    uint64_t blocks;
+    uint64_t blocks_scanned;
+    uint64_t readings_scanned;
+};
+
+// The files of an archive directory, mapped for queries
+class Archive {
+public:
+    // Maps the files of the directory. Throws std::runtime_error if a file
+    // is not an archive file.
+    explicit Archive(const std::string& directory)
+    {
+        for (uint32_t number : list_archive_files(directory)) {
+            files.emplace_back(
+                    new ArchiveFile(archive_path(directory, number)));
+            for (const BlockHeader *block : files.back()->blocks()) {
+                block_headers.push_back(block);
+            }
+        }
+    }
+
+    size_t file_count() const
+    {
+        return files.size();
+    }
+
+    size_t block_count() const
+    {
+        return block_headers.size();
+    }
+
+    // Files that end with an incomplete block: the archiver stopped while
+    // writing it, or is still writing it
+    size_t incomplete_files() const
+    {
+        size_t count = 0;
+        for (const auto& file : files) {
+            count += file->incomplete() ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Returns the readings that match the query, by time. The blocks are
+    // scanned by thread_count threads, that take the next block to scan
+    // until none is left. The readings point into the files, and are valid
+    // while the Archive exists.
+    std::vector<Reading> query(
+            const Query& query,
+            unsigned int thread_count,
+            QueryStatistics& statistics) const
+    {
+        thread_count = std::max(1u, thread_count);
+        std::atomic<size_t> next_block(0);
+        std::atomic<uint64_t> blocks_scanned(0);
+        std::atomic<uint64_t> readings_scanned(0);
+        std::vector<std::vector<Reading>> thread_matches(thread_count);
+        auto scan_blocks = [&](unsigned int thread_index) {
+            BlockScanner scanner;
+            uint64_t scanned = 0;
+            uint64_t readings = 0;
+            size_t index;
+            while ((index = next_block.fetch_add(1)) < block_headers.size()) {
+                const BlockHeader& header = *block_headers[index];
+                if (scanner.may_match(header, query)) {
+                    scanner.scan(header, query, thread_matches[thread_index]);
+                    scanned++;
+                    readings += header.row_count;
+                }
+            }
+            blocks_scanned += scanned;
+            readings_scanned += readings;
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < thread_count; i++) {
+            threads.push_back(std::thread(scan_blocks, i));
+        }
+        scan_blocks(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        std::vector<Reading> matches;
+        for (const std::vector<Reading>& readings : thread_matches) {
+            matches.insert(matches.end(), readings.begin(), readings.end());
+        }
+        // Ordered by all their fields: the result does not depend on the
+        // threads
+        std::sort(
+                matches.begin(),
+                matches.end(),
+                [](const Reading& left, const Reading& right) {
+                    if (left.timestamp_us != right.timestamp_us) {
+                        return left.timestamp_us < right.timestamp_us;
+                    }
+                    int order = std::memcmp(
+                            left.sensor_id,
+                            right.sensor_id,
+                            std::min(
+                                    left.sensor_id_length,
+                                    right.sensor_id_length));
+                    if (order != 0
+                        || left.sensor_id_length != right.sensor_id_length) {
+                        return order != 0
+                                ? order < 0
+                                : left.sensor_id_length
+                                        < right.sensor_id_length;
+                    }
+                    return left.degrees < right.degrees;
+                });
+        statistics.blocks = block_headers.size();
+        statistics.blocks_scanned = blocks_scanned;
+        statistics.readings_scanned = readings_scanned;
+        return matches;
+    }
+
+private:
+    std::vector<std::unique_ptr<ArchiveFile>> files;
+    std::vector<const BlockHeader *> block_headers;
+};
+
+}  // namespace temperature_archive
+
+#endif  // TEMPERATURE_ARCHIVE_HPP
@@ -0,0 +1,266 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "benchmark.hpp"  // Stopwatch and result printing
+
+using namespace application;
+
+// Temperature key benchmark:
+// Compares the string-keyed Temperature data type with the integer-keyed
+// TemperatureCompact data type, for SENSOR_COUNT sensors:
+// 1) Size and cost of serializing a sample
+// 2) Cost of computing the instance handle (key hash) of every sensor
+// 3) Throughput from a DataWriter to a DataReader in a second
+//    DomainParticipant that keeps one instance per sensor
+//
+// -s, --sample-count sets how many samples are written per sensor.
+
+const unsigned int SENSOR_COUNT = 10000;
+const unsigned int DEFAULT_ROUNDS = 10;
+
+// Stop waiting for samples that have not been received after this time
+const double RECEIVE_TIMEOUT_SEC = 60;
+
+void fill_sample(Temperature& sample, unsigned int index)
+{
+    // Names similar to the ones given to sensors in a production line
+    sample.sensor_id =
+            "chocolate_factory/tempering_line/sensor_" + std::to_string(index);
+    sample.degrees = 31;
+}
+
+void fill_sample(TemperatureCompact& sample, unsigned int index)
+{
+    sample.sensor_id = index;
+    sample.degrees = 31;
+}
+
+template <typename T>
+void benchmark_type(
+        const std::string& type_label,
+        const std::string& topic_name,
+        dds::core::QosProvider& qos_provider,
+        dds::domain::DomainParticipant& writer_participant,
+        dds::domain::DomainParticipant& reader_participant,
+        unsigned int rounds)
+{
+    std::vector<T> samples(SENSOR_COUNT);
+    for (unsigned int i = 0; i < SENSOR_COUNT; i++) {
+        fill_sample(samples[i], i);
+    }
+    unsigned long long total_samples =
+            static_cast<unsigned long long>(rounds) * SENSOR_COUNT;
+
+    // 1) Serialization
+    std::vector<char> buffer;
+    dds::topic::topic_type_support<T>::to_cdr_buffer(buffer, samples[0]);
+    std::cout << std::endl
+              << type_label << ": " << buffer.size()
+              << " bytes per serialized sample" << std::endl;
+
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int round = 0; round < rounds; round++) {
+        for (const auto& sample : samples) {
+            dds::topic::topic_type_support<T>::to_cdr_buffer(buffer, sample);
+        }
+    }
+    benchmark::print_result(
+            type_label + " serialize",
+            total_samples,
+            stopwatch.elapsed_seconds());
+
+    dds::topic::Topic<T> writer_topic(writer_participant, topic_name);
+    dds::topic::Topic<T> reader_topic(reader_participant, topic_name);
+    dds::pub::DataWriter<T> writer(
+            dds::pub::Publisher(writer_participant),
+            writer_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::BenchmarkProfile"));
+    dds::sub::DataReader<T> reader(
+            dds::sub::Subscriber(reader_participant),
+            reader_topic,
+            qos_provider.datareader_qos(
+                    "ChocolateFactoryLibrary::BenchmarkProfile"));
+
+    // Wait for the DataWriter to discover the DataReader
+    while (!shutdown_requested
+           && writer.publication_matched_status().current_count() == 0) {
+        rti::util::sleep(dds::core::Duration::from_millisecs(100));
+    }
+
+    // 2) Key hashing: the instance handle is computed from the key fields
+    std::vector<dds::core::InstanceHandle> handles(SENSOR_COUNT);
+    stopwatch.restart();
+    for (unsigned int i = 0; i < SENSOR_COUNT; i++) {
+        handles[i] = writer.register_instance(samples[i]);
+    }
+    benchmark::print_result(
+            type_label + " register_instance",
+            SENSOR_COUNT,
+            stopwatch.elapsed_seconds());
+
+    stopwatch.restart();
+    for (unsigned int round = 0; round < rounds; round++) {
+        for (const auto& sample : samples) {
+            writer.lookup_instance(sample);
+        }
+    }
+    benchmark::print_result(
+            type_label + " lookup_instance",
+            total_samples,
+            stopwatch.elapsed_seconds());
+
+    // 3) Throughput to a DataReader with one instance per sensor
+    unsigned long long received = 0;
+    stopwatch.restart();
+    for (unsigned int round = 0; round < rounds && !shutdown_requested;
+         round++) {
+        for (unsigned int i = 0; i < SENSOR_COUNT; i++) {
+            writer.write(samples[i], handles[i]);
+        }
+        // Drain the DataReader while writing, so its queue stays small
+        dds::sub::LoanedSamples<T> loaned_samples = reader.take();
+        received += loaned_samples.length();
+    }
+    double write_seconds = stopwatch.elapsed_seconds();
+
+    while (!shutdown_requested && received < total_samples
+           && stopwatch.elapsed_seconds() < RECEIVE_TIMEOUT_SEC) {
+        dds::sub::LoanedSamples<T> loaned_samples = reader.take();
+        if (loaned_samples.length() == 0) {
+            rti::util::sleep(dds::core::Duration::from_millisecs(1));
+        }
+        received += loaned_samples.length();
+    }
+
+    benchmark::print_result(type_label + " write", total_samples, write_seconds);
+    benchmark::print_result(
+            type_label + " write to receive",
+            received,
+            stopwatch.elapsed_seconds());
+    if (received < total_samples) {
+        std::cout << "Only " << received << " of " << total_samples
+                  << " samples received" << std::endl;
+    }
+}
+
+void run_example(
+        unsigned int domain_id,
+        unsigned int rounds,
+        const std::string& transport)
+{
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+
+    // Samples travel between two DomainParticipants, as they would between
+    // the tempering and monitoring applications
+    dds::domain::qos::DomainParticipantQos participant_qos =
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::BenchmarkProfile",
+                    transport);
+    dds::domain::DomainParticipant writer_participant(
+            domain_id,
+            participant_qos);
+    dds::domain::DomainParticipant reader_participant(
+            domain_id,
+            participant_qos);
+
+    // The benchmark uses its own Topics, so applications running in the
+    // same domain do not receive the benchmark samples
+    std::cout << "Benchmarking " << SENSOR_COUNT << " sensors, " << rounds
+              << " samples per sensor" << std::endl;
+
+    benchmark_type<Temperature>(
+            "Temperature (string key)",
+            "TemperatureKeyBenchmark",
+            qos_provider,
+            writer_participant,
+            reader_participant,
+            rounds);
+    benchmark_type<TemperatureCompact>(
+            "TemperatureCompact (uint32 key)",
+            "TemperatureCompactKeyBenchmark",
+            qos_provider,
+            writer_participant,
+            reader_participant,
+            rounds);
+
+    // With the compact data type, names are published once per sensor
+    dds::topic::Topic<SensorInfo> sensor_info_topic(
+            writer_participant,
+            "SensorInfoKeyBenchmark");
+    dds::pub::DataWriter<SensorInfo> sensor_info_writer(
+            dds::pub::Publisher(writer_participant),
+            sensor_info_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::SensorInfoProfile"));
+    SensorInfo sensor_info;
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int i = 0; i < SENSOR_COUNT; i++) {
+        Temperature named_sample;
+        fill_sample(named_sample, i);
+        sensor_info.sensor_id = i;
+        sensor_info.sensor_name = named_sample.sensor_id;
+        sensor_info_writer.write(sensor_info);
+    }
+    benchmark::print_result(
+            "SensorInfo (one-time name mapping)",
+            SENSOR_COUNT,
+            stopwatch.elapsed_seconds());
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    // The sample count defaults to infinite, use a finite number of rounds
+    unsigned int rounds = arguments.sample_count
+                    == (std::numeric_limits<unsigned int>::max)()
+            ? DEFAULT_ROUNDS
+            : arguments.sample_count;
+
+    try {
+        run_example(arguments.domain_id, rounds, arguments.transport);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TEMPERATURE_RANGE_FILTER_HPP
+#define TEMPERATURE_RANGE_FILTER_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <dds/domain/ddsdomain.hpp>
+#include <dds/topic/ddstopic.hpp>
+#include <rti/topic/ContentFilter.hpp>
+
+#include "chocolate_factory.hpp"
+
+// Custom content filter for temperatures out of a range. It accepts the same
+// expression as the builtin SQL filter used by the monitoring application:
+//
+//     "degrees > %0 or degrees < %1"
+//
+// The parameters are parsed once, when the filter is compiled or its
+// parameters change, so evaluating a sample is two integer comparisons
+// instead of interpreting the SQL expression.
+//
+// The filter must be registered with the same name in the DomainParticipants
+// of both the DataWriter and the DataReader. Otherwise the DataWriter cannot
+// filter, and every sample is sent and filtered by the DataReader.
+
+const std::string TEMPERATURE_RANGE_FILTER_NAME = "TemperatureRangeFilter";
+const std::string TEMPERATURE_RANGE_EXPRESSION = "degrees > %0 or degrees < %1";
+
+// The compiled filter: samples pass when degrees are outside [low, high]
+struct TemperatureRange {
+    int32_t high;
+    int32_t low;
+};
+
+// Parses a parameter of the expression, which must be a whole int32_t.
+// Returns false otherwise, for example for "32abc".
+inline bool parse_temperature_parameter(
+        const std::string& parameter,
+        int32_t& degrees)
+{
+    const char *begin = parameter.c_str();
+    char *end = nullptr;
+    errno = 0;
+    long value = std::strtol(begin, &end, 10);
+    if (end == begin || *end != '\0' || errno == ERANGE
+            || value < INT32_MIN || value > INT32_MAX) {
+        return false;
+    }
+    degrees = static_cast<int32_t>(value);
+    return true;
+}
+
+class TemperatureRangeFilter
+        : public rti::topic::ContentFilter<Temperature, TemperatureRange> {
+public:
+    TemperatureRange& compile(
+            const std::string& expression,
+            const dds::core::StringSeq& parameters,
+            const dds::core::optional<dds::core::xtypes::DynamicType>&,
+            const std::string&,
+            TemperatureRange *old_compile_data) override
+    {
+        if (expression != TEMPERATURE_RANGE_EXPRESSION
+                || parameters.size() != 2) {
+            throw dds::core::InvalidArgumentError(
+                    "TemperatureRangeFilter expects the expression \""
+                    + TEMPERATURE_RANGE_EXPRESSION + "\" and 2 parameters");
+        }
+
+        int32_t high = parse_degrees(parameters[0]);
+        int32_t low = parse_degrees(parameters[1]);
+
+        // Reuse the compiled data when only the parameters change
+        TemperatureRange *range = old_compile_data != nullptr
+                ? old_compile_data
+                : new TemperatureRange();
+        range->high = high;
+        range->low = low;
+        return *range;
+    }
+
+    bool evaluate(
+            TemperatureRange& range,
+            const Temperature& sample,
+            const rti::topic::FilterSampleInfo&) override
+    {
+        return sample.degrees > range.high || sample.degrees < range.low;
+    }
+
+    void finalize(TemperatureRange& range) override
+    {
+        delete &range;
+    }
+
+private:
+    static int32_t parse_degrees(const std::string& parameter)
+    {
+        int32_t degrees = 0;
+        if (!parse_temperature_parameter(parameter, degrees)) {
+            throw dds::core::InvalidArgumentError(
+                    "TemperatureRangeFilter expects 32-bit integer "
+                    "parameters, not \"" + parameter + "\"");
+        }
+        return degrees;
+    }
+};
+
+// Registers the filter in a DomainParticipant
+inline void register_temperature_range_filter(
+        dds::domain::DomainParticipant& participant)
+{
+    participant->register_contentfilter(
+            rti::topic::CustomFilter<TemperatureRangeFilter>(
+                    new TemperatureRangeFilter()),
+            TEMPERATURE_RANGE_FILTER_NAME);
+}
+
+// Creates the filter for a ContentFilteredTopic, using either the builtin SQL
+// filter or the TemperatureRangeFilter. Both filter the same range.
+inline dds::topic::Filter temperature_range_filter(
+        const std::string& high,
+        const std::string& low,
+        bool use_custom_filter)
+{
+    dds::topic::Filter filter(TEMPERATURE_RANGE_EXPRESSION, { high, low });
+    if (use_custom_filter) {
+        filter->name(TEMPERATURE_RANGE_FILTER_NAME);
+    }
+    return filter;
+}
+
+#endif  // TEMPERATURE_RANGE_FILTER_HPP
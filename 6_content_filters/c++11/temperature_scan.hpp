@@ -0,0 +1,214 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TEMPERATURE_SCAN_HPP
+#define TEMPERATURE_SCAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define TEMPERATURE_SCAN_SSE2
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+// Scans batches of temperature readings for values out of a range, and
+// computes their min/max/sum in the same pass.
+//
+// Uses AVX2 when the compiler targets it (for example -mavx2 or
+// -march=native with GCC and Clang, /arch:AVX2 with MSVC), SSE2 on other
+// x86-64 targets, and scalar code elsewhere.
+namespace temperature_scan {
+
+// Number of readings scanned by scan_block: one bit per reading in the mask
+const size_t BLOCK_SIZE = 64;
+
+// Statistics of the readings scanned so far
+struct ScanStats {
+    ScanStats()
+            : min_degrees((std::numeric_limits<int32_t>::max)()),
+              max_degrees((std::numeric_limits<int32_t>::min)()),
+              sum_degrees(0),
+              count(0)
+    {
+    }
+
+    int32_t min_degrees;
+    int32_t max_degrees;
+    int64_t sum_degrees;
+    uint64_t count;
+};
+
+namespace detail {
+
+inline uint64_t scan_scalar(
+        const int32_t *degrees,
+        size_t begin,
+        size_t end,
+        int32_t low,
+        int32_t high,
+        ScanStats& stats)
+{
+    uint64_t out_of_range = 0;
+    for (size_t i = begin; i < end; i++) {
+        int32_t value = degrees[i];
+        if (value > high || value < low) {
+            out_of_range |= uint64_t(1) << i;
+        }
+        if (value < stats.min_degrees) {
+            stats.min_degrees = value;
+        }
+        if (value > stats.max_degrees) {
+            stats.max_degrees = value;
+        }
+        stats.sum_degrees += value;
+    }
+    return out_of_range;
+}
+
+}  // namespace detail
+
+// Returns the index of the lowest bit set in a non-zero mask
+inline unsigned int lowest_bit_index(uint64_t mask)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctzll(mask));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<unsigned int>(index);
+#else
+    unsigned int index = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Scans count readings (at most BLOCK_SIZE). Bit i of the returned mask is
+// set when degrees[i] is above high or below low.
+inline uint64_t scan_block(
+        const int32_t *degrees,
+        size_t count,
+        int32_t low,
+        int32_t high,
+        ScanStats& stats)
+{
+    uint64_t out_of_range = 0;
+    size_t i = 0;
+    stats.count += count;
+
+#if defined(__AVX2__)
+    const __m256i high_vector = _mm256_set1_epi32(high);
+    const __m256i low_vector = _mm256_set1_epi32(low);
+    __m256i min_vector = _mm256_set1_epi32(stats.min_degrees);
+    __m256i max_vector = _mm256_set1_epi32(stats.max_degrees);
+    // The sums are 64-bit: each half of the values is sign-extended
+    __m256i sum_vector = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        __m256i values = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(degrees + i));
+        __m256i outside = _mm256_or_si256(
+                _mm256_cmpgt_epi32(values, high_vector),
+                _mm256_cmpgt_epi32(low_vector, values));
+        uint32_t mask = static_cast<uint32_t>(
+                _mm256_movemask_ps(_mm256_castsi256_ps(outside)));
+        out_of_range |= uint64_t(mask) << i;
+        min_vector = _mm256_min_epi32(min_vector, values);
+        max_vector = _mm256_max_epi32(max_vector, values);
+        sum_vector = _mm256_add_epi64(
+                sum_vector,
+                _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values)));
+        sum_vector = _mm256_add_epi64(
+                sum_vector,
+                _mm256_cvtepi32_epi64(_mm256_extracti128_si256(values, 1)));
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), min_vector);
+    for (int32_t lane : lanes) {
+        stats.min_degrees = lane < stats.min_degrees ? lane : stats.min_degrees;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), max_vector);
+    for (int32_t lane : lanes) {
+        stats.max_degrees = lane > stats.max_degrees ? lane : stats.max_degrees;
+    }
+    int64_t sum_lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(sum_lanes), sum_vector);
+    for (int64_t lane : sum_lanes) {
+        stats.sum_degrees += lane;
+    }
+#elif defined(TEMPERATURE_SCAN_SSE2)
+    const __m128i high_vector = _mm_set1_epi32(high);
+    const __m128i low_vector = _mm_set1_epi32(low);
+    __m128i min_vector = _mm_set1_epi32(stats.min_degrees);
+    __m128i max_vector = _mm_set1_epi32(stats.max_degrees);
+    // The sums are 64-bit. SSE2 has no sign extension: interleave the values
+    // with their sign bits.
+    __m128i sum_vector = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i values = _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(degrees + i));
+        __m128i above = _mm_cmpgt_epi32(values, high_vector);
+        __m128i below = _mm_cmpgt_epi32(low_vector, values);
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(
+                _mm_castsi128_ps(_mm_or_si128(above, below))));
+        out_of_range |= uint64_t(mask) << i;
+        // SSE2 has no 32-bit min/max: select with a comparison mask
+        __m128i less = _mm_cmpgt_epi32(min_vector, values);
+        min_vector = _mm_or_si128(
+                _mm_and_si128(less, values),
+                _mm_andnot_si128(less, min_vector));
+        __m128i greater = _mm_cmpgt_epi32(values, max_vector);
+        max_vector = _mm_or_si128(
+                _mm_and_si128(greater, values),
+                _mm_andnot_si128(greater, max_vector));
+        __m128i signs = _mm_srai_epi32(values, 31);
+        sum_vector = _mm_add_epi64(
+                sum_vector,
+                _mm_unpacklo_epi32(values, signs));
+        sum_vector = _mm_add_epi64(
+                sum_vector,
+                _mm_unpackhi_epi32(values, signs));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), min_vector);
+    for (int32_t lane : lanes) {
+        stats.min_degrees = lane < stats.min_degrees ? lane : stats.min_degrees;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), max_vector);
+    for (int32_t lane : lanes) {
+        stats.max_degrees = lane > stats.max_degrees ? lane : stats.max_degrees;
+    }
+    int64_t sum_lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sum_lanes), sum_vector);
+    for (int64_t lane : sum_lanes) {
+        stats.sum_degrees += lane;
+    }
+#endif
+
+    // Remaining readings, or all of them without SIMD support
+    return out_of_range
+            | detail::scan_scalar(degrees, i, count, low, high, stats);
+}
+
+}  // namespace temperature_scan
+
+#endif  // TEMPERATURE_SCAN_HPP
@@ -0,0 +1,154 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "temperature_scan.hpp"  // Vectorized out-of-range scan
+
+// Temperature scan test:
+// Checks that scan_block, which uses AVX2 or SSE2 when the compiler targets
+// them, returns the same masks and statistics as the scalar scan. The
+// readings include the extremes of int32_t, whose sums overflow 32 bits.
+//
+// Build with -mavx2 to test the AVX2 code, and without it to test SSE2.
+// Returns EXIT_FAILURE when a result differs.
+
+using namespace temperature_scan;
+
+const int32_t INT32_LOWEST = (std::numeric_limits<int32_t>::min)();
+const int32_t INT32_HIGHEST = (std::numeric_limits<int32_t>::max)();
+
+unsigned int failure_count = 0;
+
+// Scans the readings in blocks with scan_block and with the scalar scan, and
+// compares the results of every block
+void check_scan(
+        const std::string& name,
+        const std::vector<int32_t>& degrees,
+        int32_t low,
+        int32_t high)
+{
+    ScanStats simd_stats;
+    ScanStats scalar_stats;
+    for (size_t begin = 0; begin < degrees.size(); begin += BLOCK_SIZE) {
+        size_t count = degrees.size() - begin;
+        if (count > BLOCK_SIZE) {
+            count = BLOCK_SIZE;
+        }
+        uint64_t simd_mask =
+                scan_block(&degrees[begin], count, low, high, simd_stats);
+        uint64_t scalar_mask = detail::scan_scalar(
+                &degrees[begin],
+                0,
+                count,
+                low,
+                high,
+                scalar_stats);
+        scalar_stats.count += count;
+        if (simd_mask != scalar_mask) {
+            std::cout << name << ": mask of the block at " << begin
+                      << " is " << std::hex << simd_mask << " instead of "
+                      << scalar_mask << std::dec << std::endl;
+            failure_count++;
+            return;
+        }
+    }
+
+    if (simd_stats.min_degrees != scalar_stats.min_degrees
+            || simd_stats.max_degrees != scalar_stats.max_degrees
+            || simd_stats.sum_degrees != scalar_stats.sum_degrees
+            || simd_stats.count != scalar_stats.count) {
+        std::cout << name << ": min/max/sum/count are "
+                  << simd_stats.min_degrees << "/" << simd_stats.max_degrees
+                  << "/" << simd_stats.sum_degrees << "/" << simd_stats.count
+                  << " instead of " << scalar_stats.min_degrees << "/"
+                  << scalar_stats.max_degrees << "/"
+                  << scalar_stats.sum_degrees << "/" << scalar_stats.count
+                  << std::endl;
+        failure_count++;
+        return;
+    }
+    std::cout << name << ": OK" << std::endl;
+}
+
+// Checks the readings with a usual range, and with ranges at the extremes
+void check_ranges(const std::string& name, const std::vector<int32_t>& degrees)
+{
+    check_scan(name + ", range 30..32", degrees, 30, 32);
+    check_scan(
+            name + ", full range",
+            degrees,
+            INT32_LOWEST,
+            INT32_HIGHEST);
+    check_scan(
+            name + ", empty range",
+            degrees,
+            INT32_HIGHEST,
+            INT32_LOWEST);
+    check_scan(name + ", range 0..0", degrees, 0, 0);
+}
+
+int main()
+{
+    // Whole blocks, a partial block, and fewer readings than a SIMD register
+    const size_t sizes[] = { BLOCK_SIZE * 4, BLOCK_SIZE * 2 + 13, 3 };
+    std::mt19937 generator(1);
+
+    for (size_t size : sizes) {
+        std::string suffix = " (" + std::to_string(size) + " readings)";
+
+        check_ranges(
+                "INT32_MAX" + suffix,
+                std::vector<int32_t>(size, INT32_HIGHEST));
+        check_ranges(
+                "INT32_MIN" + suffix,
+                std::vector<int32_t>(size, INT32_LOWEST));
+
+        std::vector<int32_t> alternating(size);
+        for (size_t i = 0; i < size; i++) {
+            alternating[i] = i % 2 == 0 ? INT32_HIGHEST : INT32_LOWEST;
+        }
+        check_ranges("INT32_MAX and INT32_MIN" + suffix, alternating);
+
+        std::vector<int32_t> mixed(size);
+        const int32_t extremes[] = {
+            INT32_LOWEST, INT32_LOWEST + 1, -1, 0, 1, 30, 32,
+            INT32_HIGHEST - 1, INT32_HIGHEST
+        };
+        std::uniform_int_distribution<size_t> pick(0, 8);
+        for (int32_t& value : mixed) {
+            value = extremes[pick(generator)];
+        }
+        check_ranges("Mixed extremes" + suffix, mixed);
+
+        std::vector<int32_t> random(size);
+        std::uniform_int_distribution<int32_t> any(
+                INT32_LOWEST,
+                INT32_HIGHEST);
+        for (int32_t& value : random) {
+            value = any(generator);
+        }
+        check_ranges("Random" + suffix, random);
+    }
+
+    if (failure_count > 0) {
+        std::cout << failure_count << " checks failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "All checks passed" << std::endl;
+    return EXIT_SUCCESS;
+}
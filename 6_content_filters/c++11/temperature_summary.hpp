@@ -0,0 +1,83 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#ifndef TEMPERATURE_SUMMARY_HPP
+#define TEMPERATURE_SUMMARY_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "chocolate_factory.hpp"
+
+// Accumulates the temperature readings of each sensor over a window, and
+// produces one TemperatureSummary per sensor when the window is closed.
+class TemperatureSummaryWindows {
+public:
+    // Adds a reading to the current window of its sensor
+    void add(const Temperature& reading)
+    {
+        Window& window = windows[reading.sensor_id];
+        if (window.count == 0) {
+            window.min_degrees = reading.degrees;
+            window.max_degrees = reading.degrees;
+        } else if (reading.degrees < window.min_degrees) {
+            window.min_degrees = reading.degrees;
+        } else if (reading.degrees > window.max_degrees) {
+            window.max_degrees = reading.degrees;
+        }
+        window.sum_degrees += reading.degrees;
+        window.count++;
+    }
+
+    // Calls function(const TemperatureSummary&) for every sensor that had
+    // readings in the current window, then starts a new window
+    template <typename Function>
+    void close_window(uint32_t window_millisec, Function function)
+    {
+        for (auto& entry : windows) {
+            Window& window = entry.second;
+            if (window.count == 0) {
+                continue;
+            }
+            summary.sensor_id = entry.first;
+            summary.min_degrees = window.min_degrees;
+            summary.max_degrees = window.max_degrees;
+            summary.mean_degrees =
+                    static_cast<double>(window.sum_degrees) / window.count;
+            summary.count = window.count;
+            summary.window_millisec = window_millisec;
+            function(summary);
+
+            window = Window();
+        }
+    }
+
+private:
+    struct Window {
+        Window() : min_degrees(0), max_degrees(0), sum_degrees(0), count(0)
+        {
+        }
+
+        int32_t min_degrees;
+        int32_t max_degrees;
+        int64_t sum_degrees;
+        uint32_t count;
+    };
+
+    // One window per sensor. Entries are kept between windows so that
+    // closing a window does not allocate.
+    std::unordered_map<std::string, Window> windows;
+    TemperatureSummary summary;
+};
+
+#endif  // TEMPERATURE_SUMMARY_HPP
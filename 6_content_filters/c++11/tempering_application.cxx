@@ -10,6 +10,7 @@
  * to use the software.
  */
 
+#include <chrono>
 #include <iostream>
 #include <thread>
 
@@ -21,18 +22,28 @@
 
 #include "chocolate_factory.hpp"
 #include "application.hpp"  // Argument parsing
+#include "temperature_summary.hpp"  // Windows for TemperatureSummary
+#include "temperature_range_filter.hpp"  // Compiled temperature filter
+#include "equality_index_filter.hpp"  // Indexed next_station filter
 
 using namespace application;
 
 // Tempering application:
-// 1) Publishes the temperature
+// 1) Publishes the temperature, and a summary of it once per window
 // 2) Subscribes to the lot state
 // 3) After "processing" the lot, publishes the lot state
 
 void publish_temperature(
         dds::pub::DataWriter<Temperature> temperature_writer,
-        const std::string sensor_id)
+        dds::pub::DataWriter<TemperatureSummary> summary_writer,
+        const std::string sensor_id,
+        unsigned int summary_window_millisec)
 {
+    // Readings are summarized over windows of summary_window_millisec
+    TemperatureSummaryWindows summary_windows;
+    auto window_end = std::chrono::steady_clock::now()
+            + std::chrono::milliseconds(summary_window_millisec);
+
     // Create temperature sample for writing
     int counter = 0;
     Temperature temperature;
@@ -42,13 +53,26 @@ void publish_temperature(
         temperature.sensor_id = sensor_id;
         // Occasionally make the temperature high
         if (counter % 400 == 0) {
-            std::cout << "Temperature too high" << std::endl;
+            log_message(LogLevel::warning, "Temperature too high");
             temperature.degrees = 33;
         } else {
             temperature.degrees = rand() % 3 + 30;  // Random value between 30 and 32
         }
         temperature_writer.write(temperature);
 
+        if (summary_window_millisec > 0) {
+            summary_windows.add(temperature);
+            if (std::chrono::steady_clock::now() >= window_end) {
+                summary_windows.close_window(
+                        summary_window_millisec,
+                        [&summary_writer](const TemperatureSummary& summary) {
+                            summary_writer.write(summary);
+                        });
+                window_end += std::chrono::milliseconds(
+                        summary_window_millisec);
+            }
+        }
+
         rti::util::sleep(dds::core::Duration::from_millisecs(100));
     }
 }
@@ -69,8 +93,10 @@ void process_lot(
         if (sample.info().valid()
             && sample.data().next_station
                     == StationKind::TEMPERING_CONTROLLER) {
-            std::cout << "Processing lot #" << sample.data().lot_id
-                      << std::endl;
+            log_message(
+                    LogLevel::info,
+                    "Processing lot #",
+                    sample.data().lot_id);
 
             // Send an update that the tempering station is processing lot
             ChocolateLotState updated_state(sample.data());
@@ -88,7 +114,10 @@ void process_lot(
             dds::core::InstanceHandle instance_handle =
                     lot_state_writer.lookup_instance(updated_state);
             lot_state_writer.dispose_instance(instance_handle);
-            std::cout << "Lot completed" << std::endl;
+            // Unregister the completed lot, so that the DataWriter and the
+            // DataReaders can purge it
+            lot_state_writer.unregister_instance(instance_handle);
+            log_message(LogLevel::info, "Lot completed");
         }
     }
 }  // The LoanedSamples destructor returns the loan
@@ -111,7 +140,11 @@ void on_requested_incompatible_qos(dds::sub::DataReader<T>& reader)
     std::cout << std::endl;    
 }
 
-void run_example(unsigned int domain_id, const std::string& sensor_id)
+void run_example(
+        unsigned int domain_id,
+        const std::string& sensor_id,
+        const std::string& transport,
+        unsigned int summary_window_millisec)
 {
     // Loads the QoS from the qos_profiles.xml file. 
     dds::core::QosProvider qos_provider("./qos_profiles.xml");
@@ -121,8 +154,17 @@ void run_example(unsigned int domain_id, const std::string& sensor_id)
     // Uses TemperingApplication QoS profile to set participant name.
     dds::domain::DomainParticipant participant(
                 domain_id,
-                qos_provider.participant_qos(
-                            "ChocolateFactoryLibrary::TemperingApplication"));
+                participant_qos_with_transport(
+                            qos_provider,
+                            "ChocolateFactoryLibrary::TemperingApplication",
+                            transport));
+
+    // Register the compiled temperature filter, so the temperature DataWriter
+    // can filter for DataReaders that use it
+    register_temperature_range_filter(participant);
+    // Register the indexed next_station filter, so the lot state DataWriter
+    // can filter for the ingredient applications
+    register_equality_index_filter<ChocolateLotState>(participant);
 
     // A Topic has a name and a datatype. Create Topics.
     // Topic names are constants defined in the IDL file.
@@ -132,6 +174,9 @@ void run_example(unsigned int domain_id, const std::string& sensor_id)
     dds::topic::Topic<ChocolateLotState> lot_state_topic(
             participant,
             CHOCOLATE_LOT_STATE_TOPIC);
+    dds::topic::Topic<TemperatureSummary> summary_topic(
+            participant,
+            CHOCOLATE_TEMPERATURE_SUMMARY_TOPIC);
 
     // Exercise #1.1: Create a Content-Filtered Topic that filters out
     // chocolate lot state unless the next_station = TEMPERING_CONTROLLER
@@ -148,6 +193,14 @@ void run_example(unsigned int domain_id, const std::string& sensor_id)
             qos_provider.datawriter_qos(
                     "ChocolateFactoryLibrary::ChocolateTemperatureProfile"));
 
+    // Create DataWriter of Topic "ChocolateTemperatureSummary"
+    dds::pub::DataWriter<TemperatureSummary> summary_writer(
+            publisher,
+            summary_topic,
+            qos_provider.datawriter_qos(
+                    "ChocolateFactoryLibrary::"
+                    "ChocolateTemperatureSummaryProfile"));
+
     // Create DataWriter of Topic "ChocolateLotState"
     // using ChocolateLotStateProfile QoS profile for State Data
     dds::pub::DataWriter<ChocolateLotState> lot_state_writer(
@@ -205,11 +258,13 @@ void run_example(unsigned int domain_id, const std::string& sensor_id)
     std::thread temperature_thread(
             publish_temperature,
             temperature_writer,
-            sensor_id);
+            summary_writer,
+            sensor_id,
+            summary_window_millisec);
 
     while (!shutdown_requested) {
         // Wait for ChocolateLotState
-        std::cout << "Waiting for lot" << std::endl;
+        log_message(LogLevel::info, "Waiting for lot");
         waitset.dispatch(dds::core::Duration(10));  // Wait up to 10s for update
     }
 
@@ -230,8 +285,15 @@ int main(int argc, char *argv[])
     // Sets Connext verbosity to help debugging
     rti::config::Logger::instance().verbosity(arguments.verbosity);
 
+    // Writes the log messages of the data paths in the background
+    LogWriter log_writer(arguments.log_level);
+
     try {
-        run_example(arguments.domain_id, arguments.sensor_id);
+        run_example(
+                arguments.domain_id,
+                arguments.sensor_id,
+                arguments.transport,
+                arguments.summary_window_millisec);
     } catch (const std::exception& ex) {
         // This will catch DDS exceptions
         std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
@@ -0,0 +1,292 @@
+/*
+ * (c) Copyright, Real-Time Innovations, 2020.  All rights reserved.
+ * RTI grants Licensee a license to use, modify, compile, and create derivative
+ * works of the software solely for use with RTI Connext DDS. Licensee may
+ * redistribute copies of the software provided that all such copies are subject
+ * to this license. The software is provided "as is", with no warranty of any
+ * type, including any warranty for fitness for any purpose. RTI is under no
+ * obligation to maintain or support the software. RTI shall not be liable for
+ * any incidental or consequential damages arising out of the use or inability
+ * to use the software.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <dds/pub/ddspub.hpp>
+#include <dds/sub/ddssub.hpp>
+#include <rti/util/util.hpp>  // for sleep()
+#include <rti/config/Logger.hpp>  // for logging
+// Or simply include <dds/dds.hpp>
+
+#include "chocolate_factory.hpp"
+#include "application.hpp"  // Argument parsing
+#include "benchmark.hpp"  // Stopwatch and result printing
+
+using namespace application;
+
+// Transport benchmark:
+// Measures latency and throughput between two DomainParticipants that use
+// the transports selected with -t, --transport:
+// 1) Latency: Temperature samples are echoed back (ping-pong). Reports half
+//    of the round-trip time.
+// 2) Throughput: time to deliver a burst of Temperature samples.
+//
+// transport_comparison.sh runs this benchmark with every transport.
+
+const unsigned int LATENCY_SAMPLES = 10000;
+const unsigned int THROUGHPUT_SAMPLES = 100000;
+
+// Stop waiting for samples that have not been received after this time
+const double RECEIVE_TIMEOUT_SEC = 60;
+
+// Echoes ping samples back on the pong Topic and counts throughput samples,
+// until done is set
+void echo_samples(
+        dds::sub::DataReader<Temperature> ping_reader,
+        dds::pub::DataWriter<Temperature> pong_writer,
+        dds::sub::DataReader<Temperature> throughput_reader,
+        std::atomic<unsigned long long>& throughput_received,
+        std::atomic<bool>& done)
+{
+    dds::core::cond::StatusCondition ping_condition(ping_reader);
+    ping_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    ping_condition.extensions().handler([&ping_reader, &pong_writer]() {
+        dds::sub::LoanedSamples<Temperature> samples = ping_reader.take();
+        for (const auto& sample : samples) {
+            if (sample.info().valid()) {
+                pong_writer.write(sample.data());
+            }
+        }
+    });
+
+    dds::core::cond::StatusCondition throughput_condition(throughput_reader);
+    throughput_condition.enabled_statuses(
+            dds::core::status::StatusMask::data_available());
+    throughput_condition.extensions().handler(
+            [&throughput_reader, &throughput_received]() {
+                dds::sub::LoanedSamples<Temperature> samples =
+                        throughput_reader.take();
+                throughput_received += samples.length();
+            });
+
+    dds::core::cond::WaitSet waitset;
+    waitset += ping_condition;
+    waitset += throughput_condition;
+    while (!done && !shutdown_requested) {
+        waitset.dispatch(dds::core::Duration::from_millisecs(100));
+    }
+}
+
+template <typename T>
+void wait_for_match(dds::pub::DataWriter<T>& writer)
+{
+    while (!shutdown_requested
+           && writer.publication_matched_status().current_count() == 0) {
+        rti::util::sleep(dds::core::Duration::from_millisecs(100));
+    }
+}
+
+void measure_latency(
+        dds::pub::DataWriter<Temperature>& ping_writer,
+        dds::sub::DataReader<Temperature>& pong_reader)
+{
+    dds::sub::cond::ReadCondition pong_condition(
+            pong_reader,
+            dds::sub::status::DataState::any());
+    dds::core::cond::WaitSet waitset;
+    waitset += pong_condition;
+
+    std::vector<double> latencies_us;
+    latencies_us.reserve(LATENCY_SAMPLES);
+    Temperature ping;
+    ping.sensor_id = "transport_benchmark";
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int i = 0; i < LATENCY_SAMPLES && !shutdown_requested;
+         i++) {
+        ping.degrees = static_cast<int32_t>(i);
+        stopwatch.restart();
+        ping_writer.write(ping);
+
+        bool echoed = false;
+        while (!echoed && !shutdown_requested
+               && stopwatch.elapsed_seconds() < RECEIVE_TIMEOUT_SEC) {
+            waitset.wait(dds::core::Duration::from_millisecs(100));
+            dds::sub::LoanedSamples<Temperature> samples = pong_reader.take();
+            for (const auto& sample : samples) {
+                if (sample.info().valid()
+                    && sample.data().degrees == ping.degrees) {
+                    echoed = true;
+                }
+            }
+        }
+        if (!echoed) {
+            std::cout << "Ping " << i << " was not echoed" << std::endl;
+            return;
+        }
+        latencies_us.push_back(stopwatch.elapsed_seconds() * 1e6 / 2);
+    }
+    if (latencies_us.empty()) {
+        return;
+    }
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    double total_us = 0;
+    for (double latency : latencies_us) {
+        total_us += latency;
+    }
+    std::cout << "Latency (us, half round-trip) over " << latencies_us.size()
+              << " samples: average "
+              << total_us / latencies_us.size() << ", p50 "
+              << latencies_us[latencies_us.size() / 2] << ", p99 "
+              << latencies_us[latencies_us.size() * 99 / 100] << ", max "
+              << latencies_us.back() << std::endl;
+}
+
+void measure_throughput(
+        dds::pub::DataWriter<Temperature>& throughput_writer,
+        std::atomic<unsigned long long>& throughput_received)
+{
+    Temperature sample;
+    sample.sensor_id = "transport_benchmark";
+    benchmark::Stopwatch stopwatch;
+    for (unsigned int i = 0; i < THROUGHPUT_SAMPLES && !shutdown_requested;
+         i++) {
+        sample.degrees = static_cast<int32_t>(i);
+        throughput_writer.write(sample);
+    }
+    while (!shutdown_requested && throughput_received < THROUGHPUT_SAMPLES
+           && stopwatch.elapsed_seconds() < RECEIVE_TIMEOUT_SEC) {
+        rti::util::sleep(dds::core::Duration::from_millisecs(1));
+    }
+    benchmark::print_result(
+            "Throughput (samples delivered)",
+            throughput_received,
+            stopwatch.elapsed_seconds());
+}
+
+void run_example(unsigned int domain_id, const std::string& transport)
+{
+    // Loads the QoS from the qos_profiles.xml file.
+    dds::core::QosProvider qos_provider("./qos_profiles.xml");
+    dds::domain::qos::DomainParticipantQos participant_qos =
+            participant_qos_with_transport(
+                    qos_provider,
+                    "ChocolateFactoryLibrary::BenchmarkProfile",
+                    transport);
+    dds::pub::qos::DataWriterQos writer_qos = qos_provider.datawriter_qos(
+            "ChocolateFactoryLibrary::BenchmarkProfile");
+    dds::sub::qos::DataReaderQos reader_qos = qos_provider.datareader_qos(
+            "ChocolateFactoryLibrary::BenchmarkProfile");
+
+    std::cout << "Transport: " << transport << std::endl;
+
+    // Two DomainParticipants: samples go through the selected transports
+    // even though both are in this process
+    dds::domain::DomainParticipant participant(domain_id, participant_qos);
+    dds::domain::DomainParticipant echo_participant(domain_id, participant_qos);
+
+    // The benchmark uses its own Topics, so applications running in the
+    // same domain do not receive the benchmark samples
+    dds::topic::Topic<Temperature> ping_topic(
+            participant,
+            "TransportBenchmarkPing");
+    dds::topic::Topic<Temperature> pong_topic(
+            participant,
+            "TransportBenchmarkPong");
+    dds::topic::Topic<Temperature> throughput_topic(
+            participant,
+            "TransportBenchmarkThroughput");
+    dds::topic::Topic<Temperature> echo_ping_topic(
+            echo_participant,
+            "TransportBenchmarkPing");
+    dds::topic::Topic<Temperature> echo_pong_topic(
+            echo_participant,
+            "TransportBenchmarkPong");
+    dds::topic::Topic<Temperature> echo_throughput_topic(
+            echo_participant,
+            "TransportBenchmarkThroughput");
+
+    dds::pub::Publisher publisher(participant);
+    dds::sub::Subscriber subscriber(participant);
+    dds::pub::DataWriter<Temperature> ping_writer(
+            publisher,
+            ping_topic,
+            writer_qos);
+    dds::pub::DataWriter<Temperature> throughput_writer(
+            publisher,
+            throughput_topic,
+            writer_qos);
+    dds::sub::DataReader<Temperature> pong_reader(
+            subscriber,
+            pong_topic,
+            reader_qos);
+
+    dds::pub::Publisher echo_publisher(echo_participant);
+    dds::sub::Subscriber echo_subscriber(echo_participant);
+    dds::pub::DataWriter<Temperature> pong_writer(
+            echo_publisher,
+            echo_pong_topic,
+            writer_qos);
+    dds::sub::DataReader<Temperature> ping_reader(
+            echo_subscriber,
+            echo_ping_topic,
+            reader_qos);
+    dds::sub::DataReader<Temperature> throughput_reader(
+            echo_subscriber,
+            echo_throughput_topic,
+            reader_qos);
+
+    std::atomic<unsigned long long> throughput_received(0);
+    std::atomic<bool> done(false);
+    std::thread echo_thread(
+            echo_samples,
+            ping_reader,
+            pong_writer,
+            throughput_reader,
+            std::ref(throughput_received),
+            std::ref(done));
+
+    wait_for_match(ping_writer);
+    wait_for_match(pong_writer);
+    wait_for_match(throughput_writer);
+
+    measure_latency(ping_writer, pong_reader);
+    measure_throughput(throughput_writer, throughput_received);
+
+    done = true;
+    echo_thread.join();
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse arguments and handle control-C
+    auto arguments = parse_arguments(argc, argv);
+    if (arguments.parse_result == ParseReturn::exit) {
+        return EXIT_SUCCESS;
+    } else if (arguments.parse_result == ParseReturn::failure) {
+        return EXIT_FAILURE;
+    }
+    setup_signal_handlers();
+
+    // Sets Connext verbosity to help debugging
+    rti::config::Logger::instance().verbosity(arguments.verbosity);
+
+    try {
+        run_example(arguments.domain_id, arguments.transport);
+    } catch (const std::exception& ex) {
+        // This will catch DDS exceptions
+        std::cerr << "Exception in run_example(): " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Releases the memory used by the participant factory.  Optional at
+    // application shutdown
+    dds::domain::DomainParticipant::finalize_participant_factory();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+
+# Compares latency and throughput of the transport selection profiles by
+# running transport_benchmark once per transport. Run it from the directory
+# that contains transport_benchmark and qos_profiles.xml. Additional
+# arguments (for example -d <domain>) are passed to every run.
+
+filename=$0
+script_dir=`dirname $filename`
+executable_name="transport_benchmark"
+bin_dir=$script_dir
+
+if [ ! -f $bin_dir/$executable_name ]
+then
+    echo "***************************************************************"
+    echo $executable_name executable does not exist in:
+    echo $bin_dir
+    echo ""
+    echo "***************************************************************"
+    exit 1
+fi
+
+for transport in shmem udp both
+do
+    echo ""
+    echo "==============================================================="
+    $bin_dir/$executable_name -t $transport $*
+done
@@ -17,6 +17,7 @@
 #include <csignal>
 #include <ctime>
 #include <limits>
+#include <vector>
 
 #ifdef RTI_WIN32
   /* strtok, fopen warnings */
@@ -110,6 +111,464 @@ private:
     void *function_param;
 };
 
+// Levels of the log messages, from the most to the least important
+enum LogLevel {
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARNING,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG
+};
+
+// Messages less important than this level are not logged: LogLine copies
+// nothing, but the values passed to it are still evaluated. For example,
+// -DAPPLICATION_LOG_LEVEL=1 keeps only errors and warnings.
+#ifndef APPLICATION_LOG_LEVEL
+    #define APPLICATION_LOG_LEVEL 3
+#endif
+
+// Counters shared by the threads of the log. A thread that loads a value
+// sees what the thread that stored it wrote before.
+inline unsigned long log_load_acquire(const volatile unsigned long *counter)
+{
+#ifdef RTI_WIN32
+    unsigned long value = *counter;
+    MemoryBarrier();
+    return value;
+#else
+    return __atomic_load_n(counter, __ATOMIC_ACQUIRE);
+#endif
+}
+
+inline void log_store_release(volatile unsigned long *counter, unsigned long value)
+{
+#ifdef RTI_WIN32
+    MemoryBarrier();
+    *counter = value;
+#else
+    __atomic_store_n(counter, value, __ATOMIC_RELEASE);
+#endif
+}
+
+// The values of a log message, not formatted yet. Strings are copied, and
+// truncated when they do not fit.
+struct LogRecord {
+    enum { MAX_VALUES = 12, TEXT_SIZE = 192 };
+    enum ValueKind { TEXT, SIGNED, UNSIGNED, REAL };
+
+    struct Value {
+        ValueKind kind;
+        union {
+            // Offset of the string in text
+            unsigned int text_offset;
+            long long signed_value;
+            unsigned long long unsigned_value;
+            double real_value;
+        };
+    };
+
+    void clear()
+    {
+        value_count = 0;
+        text_size = 0;
+    }
+
+    Value *add(ValueKind kind)
+    {
+        if (value_count == MAX_VALUES) {
+            return NULL;
+        }
+        Value *value = &values[value_count++];
+        value->kind = kind;
+        return value;
+    }
+
+    void add_text(const char *string)
+    {
+        Value *value = add(TEXT);
+        if (value == NULL) {
+            return;
+        }
+        if (text_size == TEXT_SIZE) {
+            // Full: the empty string at the end of the last one
+            value->text_offset = TEXT_SIZE - 1;
+            return;
+        }
+        value->text_offset = text_size;
+        while (*string != '\0' && text_size < TEXT_SIZE - 1) {
+            text[text_size++] = *string++;
+        }
+        text[text_size++] = '\0';
+    }
+
+    void print(std::ostream& out) const
+    {
+        for (unsigned int i = 0; i < value_count; i++) {
+            const Value& value = values[i];
+            switch (value.kind) {
+            case TEXT:
+                out << &text[value.text_offset];
+                break;
+            case SIGNED:
+                out << value.signed_value;
+                break;
+            case UNSIGNED:
+                out << value.unsigned_value;
+                break;
+            case REAL:
+                out << value.real_value;
+                break;
+            }
+        }
+        out << '\n';
+    }
+
+    Value values[MAX_VALUES];
+    unsigned int value_count;
+    char text[TEXT_SIZE];
+    unsigned int text_size;
+};
+
+// Single-producer, single-consumer ring of log records: the thread that
+// owns it pushes, and the writer thread pops. The counters only grow, and
+// each is stored by one thread only.
+struct LogRing {
+    enum { CAPACITY = 1024 };
+
+    LogRing() : head(0), dropped(0), tail(0), dropped_reported(0), closed(0)
+    {
+    }
+
+    void push(const LogRecord& record)
+    {
+        unsigned long next = head;
+        if (next - log_load_acquire(&tail) >= CAPACITY) {
+            log_store_release(&dropped, dropped + 1);
+            return;
+        }
+        records[next % CAPACITY] = record;
+        log_store_release(&head, next + 1);
+    }
+
+    // Writes the records pushed so far, and returns how many
+    unsigned long pop_all(std::ostream& out)
+    {
+        unsigned long first = tail;
+        unsigned long last = log_load_acquire(&head);
+        for (unsigned long next = first; next != last; next++) {
+            records[next % CAPACITY].print(out);
+            log_store_release(&tail, next + 1);
+        }
+        return last - first;
+    }
+
+    // Returns the messages dropped since the last call
+    unsigned long take_dropped()
+    {
+        unsigned long total = log_load_acquire(&dropped);
+        unsigned long count = total - dropped_reported;
+        dropped_reported = total;
+        return count;
+    }
+
+    LogRecord records[CAPACITY];
+    // Stored by the owner thread
+    volatile unsigned long head;
+    volatile unsigned long dropped;
+    // Stored by the writer thread
+    volatile unsigned long tail;
+    unsigned long dropped_reported;
+    // 1 when the thread has exited: the ring is deleted once empty
+    volatile unsigned long closed;
+};
+
+// Asynchronous log for the data paths of the applications. Logging a message
+// copies its values into a ring buffer of the calling thread, without
+// locking, formatting or flushing. A writer thread formats the messages of
+// every ring, and flushes once per batch.
+//
+// The messages of a thread are written in order, but those of different
+// threads may be interleaved in another order. When the ring of a thread is
+// full, its messages are dropped and counted, so logging never blocks.
+//
+// Create a LogWriter in main(), before other threads log.
+class AsyncLog {
+public:
+    static AsyncLog& instance()
+    {
+        static AsyncLog log;
+        return log;
+    }
+
+    bool enabled(LogLevel level) const
+    {
+        return level <= APPLICATION_LOG_LEVEL && level <= runtime_level;
+    }
+
+    void level(LogLevel level)
+    {
+        runtime_level = level;
+    }
+
+    // Copies the record for the writer thread, or writes it at once if it is
+    // not running
+    void write(const LogRecord& record)
+    {
+        if (log_load_acquire(&running) == 0) {
+            record.print(std::cout);
+            std::cout.flush();
+            return;
+        }
+        thread_ring()->push(record);
+    }
+
+    void start()
+    {
+        if (running != 0) {
+            return;
+        }
+        log_store_release(&running, 1);
+        writer.run();
+    }
+
+    // Stops the writer thread, after it has written the pending messages
+    void stop()
+    {
+        if (running == 0) {
+            return;
+        }
+        log_store_release(&running, 0);
+        writer.join();
+        drain();
+    }
+
+private:
+    AsyncLog()
+            : runtime_level(LOG_LEVEL_INFO),
+              running(0),
+              writer(write_messages, this)
+    {
+#ifdef RTI_WIN32
+        // Unlike TlsAlloc, FlsAlloc calls close_ring when a thread exits
+        ring_key = FlsAlloc(close_thread_ring);
+        InitializeCriticalSection(&rings_mutex);
+#else
+        pthread_key_create(&ring_key, close_ring);
+        pthread_mutex_init(&rings_mutex, NULL);
+#endif
+    }
+
+    ~AsyncLog()
+    {
+        stop();
+    }
+
+    // Called when a thread that has logged exits
+    static void close_ring(void *ring)
+    {
+        log_store_release(&static_cast<LogRing *>(ring)->closed, 1);
+    }
+
+#ifdef RTI_WIN32
+    static VOID WINAPI close_thread_ring(PVOID ring)
+    {
+        if (ring != NULL) {
+            close_ring(ring);
+        }
+    }
+#endif
+
+    static void *write_messages(void *log)
+    {
+        AsyncLog *async_log = static_cast<AsyncLog *>(log);
+        DDS_Duration_t idle_period = { 0, 1000000 };
+        while (log_load_acquire(&async_log->running) != 0) {
+            if (async_log->drain() == 0) {
+                NDDSUtility::sleep(idle_period);
+            }
+        }
+        return NULL;
+    }
+
+    void lock()
+    {
+#ifdef RTI_WIN32
+        EnterCriticalSection(&rings_mutex);
+#else
+        pthread_mutex_lock(&rings_mutex);
+#endif
+    }
+
+    void unlock()
+    {
+#ifdef RTI_WIN32
+        LeaveCriticalSection(&rings_mutex);
+#else
+        pthread_mutex_unlock(&rings_mutex);
+#endif
+    }
+
+    // Returns the ring of the calling thread, created by its first message
+    LogRing *thread_ring()
+    {
+#ifdef RTI_WIN32
+        LogRing *ring = static_cast<LogRing *>(FlsGetValue(ring_key));
+#else
+        LogRing *ring = static_cast<LogRing *>(pthread_getspecific(ring_key));
+#endif
+        if (ring == NULL) {
+            ring = new LogRing();
+#ifdef RTI_WIN32
+            FlsSetValue(ring_key, ring);
+#else
+            pthread_setspecific(ring_key, ring);
+#endif
+            lock();
+            rings.push_back(ring);
+            unlock();
+        }
+        return ring;
+    }
+
+    // Writes the messages of every ring, and the number of messages dropped.
+    // Returns how many messages were written.
+    unsigned long drain()
+    {
+        lock();
+        unsigned long count = 0;
+        unsigned long dropped = 0;
+        for (size_t i = 0; i < rings.size();) {
+            LogRing *ring = rings[i];
+            // A closed ring gets no more messages once drained
+            bool closed = log_load_acquire(&ring->closed) != 0;
+            count += ring->pop_all(std::cout);
+            dropped += ring->take_dropped();
+            if (closed) {
+                delete ring;
+                rings.erase(rings.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        unlock();
+        if (dropped > 0) {
+            std::cout << "[" << dropped << " log messages dropped]\n";
+        }
+        if (count > 0 || dropped > 0) {
+            std::cout.flush();
+        }
+        return count;
+    }
+
+    volatile LogLevel runtime_level;
+    // 1 while the writer thread runs
+    volatile unsigned long running;
+    OSThread writer;
+#ifdef RTI_WIN32
+    DWORD ring_key;
+    CRITICAL_SECTION rings_mutex;
+#else
+    pthread_key_t ring_key;
+    pthread_mutex_t rings_mutex;
+#endif
+    std::vector<LogRing *> rings;
+};
+
+// Builds a log message with operator<<, and logs it when destroyed if its
+// level is enabled. For example:
+//     LogLine(LOG_LEVEL_INFO) << "Processing lot #" << lot_id;
+class LogLine {
+public:
+    explicit LogLine(LogLevel level)
+            : enabled(AsyncLog::instance().enabled(level))
+    {
+        record.clear();
+    }
+
+    ~LogLine()
+    {
+        if (enabled) {
+            AsyncLog::instance().write(record);
+        }
+    }
+
+    LogLine& operator<<(const char *string)
+    {
+        if (enabled) {
+            record.add_text(string);
+        }
+        return *this;
+    }
+
+    LogLine& operator<<(long long value)
+    {
+        LogRecord::Value *added =
+                enabled ? record.add(LogRecord::SIGNED) : NULL;
+        if (added != NULL) {
+            added->signed_value = value;
+        }
+        return *this;
+    }
+
+    LogLine& operator<<(unsigned long long value)
+    {
+        LogRecord::Value *added =
+                enabled ? record.add(LogRecord::UNSIGNED) : NULL;
+        if (added != NULL) {
+            added->unsigned_value = value;
+        }
+        return *this;
+    }
+
+    LogLine& operator<<(int value)
+    {
+        return *this << static_cast<long long>(value);
+    }
+
+    LogLine& operator<<(long value)
+    {
+        return *this << static_cast<long long>(value);
+    }
+
+    LogLine& operator<<(unsigned int value)
+    {
+        return *this << static_cast<unsigned long long>(value);
+    }
+
+    LogLine& operator<<(unsigned long value)
+    {
+        return *this << static_cast<unsigned long long>(value);
+    }
+
+    LogLine& operator<<(double value)
+    {
+        LogRecord::Value *added = enabled ? record.add(LogRecord::REAL) : NULL;
+        if (added != NULL) {
+            added->real_value = value;
+        }
+        return *this;
+    }
+
+private:
+    bool enabled;
+    LogRecord record;
+};
+
+// Runs the writer thread of the log while it exists. Its destructor writes
+// the messages that are still pending.
+class LogWriter {
+public:
+    explicit LogWriter(LogLevel level)
+    {
+        AsyncLog::instance().level(level);
+        AsyncLog::instance().start();
+    }
+
+    ~LogWriter()
+    {
+        AsyncLog::instance().stop();
+    }
+};
+
 enum ParseReturn { PARSE_RETURN_OK, PARSE_RETURN_FAILURE, PARSE_RETURN_EXIT };
 
 struct ApplicationArguments {
@@ -118,9 +577,77 @@ struct ApplicationArguments {
     unsigned int sample_count;
     char sensor_id[256];
     char station_kind[256];
+    char transport[256];
     NDDS_Config_LogVerbosity verbosity;
+    LogLevel log_level;
 };
 
+// Returns the name of the QoS profile with the transport settings selected
+// with -t, --transport, or NULL for the builtin transports
+inline const char *transport_profile_name(const char *transport)
+{
+    if (strcmp(transport, "shmem") == 0) {
+        return "Transport.SharedMemory";
+    } else if (strcmp(transport, "udp") == 0) {
+        return "Transport.UDPv4Loopback";
+    } else if (strcmp(transport, "both") == 0) {
+        return "Transport.SharedMemoryAndUDPv4";
+    }
+    return NULL;
+}
+
+// Creates a DomainParticipant with the QoS of an application profile, and the
+// transport settings of the profile selected with -t, --transport on top of
+// it. Returns NULL on error.
+inline DDSDomainParticipant *create_participant_with_transport(
+        unsigned int domain_id,
+        const char *profile,
+        const char *transport)
+{
+    DDSDomainParticipantFactory *factory =
+            DDSDomainParticipantFactory::get_instance();
+    DDS_DomainParticipantQos qos;
+    DDS_ReturnCode_t retcode = factory->get_participant_qos_from_profile(
+            qos,
+            "ChocolateFactoryLibrary",
+            profile);
+    if (retcode != DDS_RETCODE_OK) {
+        return NULL;
+    }
+
+    const char *transport_profile = transport_profile_name(transport);
+    if (transport_profile != NULL) {
+        DDS_DomainParticipantQos transport_qos;
+        retcode = factory->get_participant_qos_from_profile(
+                transport_qos,
+                "ChocolateFactoryLibrary",
+                transport_profile);
+        if (retcode != DDS_RETCODE_OK) {
+            return NULL;
+        }
+        qos.transport_builtin = transport_qos.transport_builtin;
+        qos.discovery = transport_qos.discovery;
+        // Keep the properties of the application profile, add the transport
+        // ones
+        for (int i = 0; i < transport_qos.property.value.length(); i++) {
+            const DDS_Property_t& entry = transport_qos.property.value[i];
+            retcode = DDSPropertyQosPolicyHelper::assert_property(
+                    qos.property,
+                    entry.name,
+                    entry.value,
+                    entry.propagate);
+            if (retcode != DDS_RETCODE_OK) {
+                return NULL;
+            }
+        }
+    }
+
+    return factory->create_participant(
+            domain_id,
+            qos,
+            NULL /* listener */,
+            DDS_STATUS_MASK_NONE);
+}
 
 // Parses application arguments for example.  Returns whether to exit.
 inline void parse_arguments(
@@ -133,10 +660,12 @@ inline void parse_arguments(
     arguments.domain_id = 0;
     arguments.sample_count = (std::numeric_limits<unsigned int>::max)();
     arguments.verbosity = NDDS_CONFIG_LOG_VERBOSITY_ERROR;
+    arguments.log_level = LOG_LEVEL_INFO;
     arguments.parse_result = PARSE_RETURN_OK;
     // Initialize with an integer value
     srand((unsigned int)time(NULL));
     snprintf(arguments.sensor_id, 255, "%d", rand() % 10);
+    snprintf(arguments.transport, 255, "%s", "default");
 
     while (arg_processing < argc) {
         if ((argc > arg_processing + 1)
@@ -159,12 +688,44 @@ inline void parse_arguments(
                 || strcmp(argv[arg_processing], "--station-kind") == 0)) {
             snprintf(arguments.station_kind, 255, "%s", argv[arg_processing + 1]);
             arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-t") == 0
+                || strcmp(argv[arg_processing], "--transport") == 0)) {
+            snprintf(arguments.transport, 255, "%s", argv[arg_processing + 1]);
+            arg_processing += 2;
+            if (strcmp(arguments.transport, "default") != 0
+                    && transport_profile_name(arguments.transport) == NULL) {
+                std::cout << "Bad transport: " << arguments.transport
+                          << std::endl;
+                show_usage = true;
+                arguments.parse_result = PARSE_RETURN_FAILURE;
+                break;
+            }
         } else if ((argc > arg_processing + 1)
                 && (strcmp(argv[arg_processing], "-v") == 0
                 || strcmp(argv[arg_processing], "--verbosity") == 0)) {
             arguments.verbosity =
                     (NDDS_Config_LogVerbosity) atoi(argv[arg_processing + 1]);
             arg_processing += 2;
+        } else if ((argc > arg_processing + 1)
+                && (strcmp(argv[arg_processing], "-l") == 0
+                || strcmp(argv[arg_processing], "--log-level") == 0)) {
+            const char *level = argv[arg_processing + 1];
+            arg_processing += 2;
+            if (strcmp(level, "error") == 0) {
+                arguments.log_level = LOG_LEVEL_ERROR;
+            } else if (strcmp(level, "warning") == 0) {
+                arguments.log_level = LOG_LEVEL_WARNING;
+            } else if (strcmp(level, "info") == 0) {
+                arguments.log_level = LOG_LEVEL_INFO;
+            } else if (strcmp(level, "debug") == 0) {
+                arguments.log_level = LOG_LEVEL_DEBUG;
+            } else {
+                std::cout << "Bad log level: " << level << std::endl;
+                show_usage = true;
+                arguments.parse_result = PARSE_RETURN_FAILURE;
+                break;
+            }
         } else if (strcmp(argv[arg_processing], "-h") == 0
                 || strcmp(argv[arg_processing], "--help") == 0) {
             std::cout << "Example application." << std::endl;
@@ -194,6 +755,17 @@ inline void parse_arguments(
                     "                                   SUGAR_CONTROLLER,\n"\
                     "                                   MILK_CONTROLLER,\n"\
                     "                                   VANILLA_CONTROLLER\n"\
+                    "    -t, --transport    <string> Transports used to communicate.\n"\
+                    "                                Values:\n"\
+                    "                                   shmem (shared memory only),\n"\
+                    "                                   udp (UDPv4 loopback only),\n"\
+                    "                                   both (shared memory and UDPv4),\n"\
+                    "                                   default (builtin transports)\n"\
+                    "                                Default: default\n"\
+                    "    -l, --log-level    <string> Least important messages logged.\n"\
+                    "                                Values:\n"\
+                    "                                   error, warning, info, debug\n"\
+                    "                                Default: info\n"\
                     "    -v, --verbosity    <int>    How much debugging output to show.\n"\
                     "                                Range: 0-5 \n"
                     "                                Default: 0"
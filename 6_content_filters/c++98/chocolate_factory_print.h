@@ -1,58 +1,98 @@
 #include <iostream>
+#include <stdio.h>
 #include "chocolate_factoryPlugin.h"
 
 namespace chocolate_factory
 {
 
-inline void print_station_kind(StationKind station_kind)
+// Names of the enumerators, in the order of chocolate_factory.idl
+inline const char *station_kind_name(StationKind station_kind)
+{
+    static const char *const NAMES[] = {
+        "INVALID_CONTROLLER",
+        "COCOA_BUTTER_CONTROLLER",
+        "SUGAR_CONTROLLER",
+        "MILK_CONTROLLER",
+        "VANILLA_CONTROLLER",
+        "TEMPERING_CONTROLLER"
+    };
+    size_t index = static_cast<size_t>(station_kind);
+    return index < sizeof(NAMES) / sizeof(NAMES[0]) ? NAMES[index] : "";
+}
+
+inline const char *lot_status_kind_name(LotStatusKind lot_status_kind)
+{
+    static const char *const NAMES[] = {
+        "WAITING",
+        "PROCESSING",
+        "COMPLETED"
+    };
+    size_t index = static_cast<size_t>(lot_status_kind);
+    return index < sizeof(NAMES) / sizeof(NAMES[0]) ? NAMES[index] : "";
+}
+
+// Large enough for any ChocolateLotState, and for a Temperature with a
+// sensor_id of up to 64 characters: a longer one is truncated
+const size_t SAMPLE_TEXT_SIZE = 128;
+
+// Length of the text snprintf wrote into a buffer of size bytes
+inline size_t written_length(int length, size_t size)
 {
-    switch(station_kind) {
-    case INVALID_CONTROLLER:
-        std::cout << "INVALID_CONTROLLER";
-        break;
-    case SUGAR_CONTROLLER:
-        std::cout << "SUGAR_CONTROLLER";
-        break;
-    case COCOA_BUTTER_CONTROLLER:
-        std::cout << "COCOA_BUTTER_CONTROLLER";
-        break;
-    case VANILLA_CONTROLLER:
-        std::cout << "VANILLA_CONTROLLER";
-        break;
-    case MILK_CONTROLLER:
-        std::cout << "MILK_CONTROLLER";
-        break;
-    case TEMPERING_CONTROLLER:
-        std::cout << "TEMPERING_CONTROLLER";
-        break;
+    if (length < 0 || size == 0) {
+        return 0;
     }
+    size_t written = static_cast<size_t>(length);
+    return written < size ? written : size - 1;
+}
+
+// Writes "[lot_id: 1, station: ..., next_station: ..., lot_status: ...]"
+// and returns its length
+inline size_t format_chocolate_lot_data(
+        const ChocolateLotState& sample,
+        char *buffer,
+        size_t size)
+{
+    int length = snprintf(
+            buffer,
+            size,
+            "[lot_id: %u, station: %s, next_station: %s, lot_status: %s]",
+            static_cast<unsigned int>(sample.lot_id),
+            station_kind_name(sample.station),
+            station_kind_name(sample.next_station),
+            lot_status_kind_name(sample.lot_status));
+    return written_length(length, size);
+}
+
+// Writes "[sensor_id: ..., degrees: 32]" and returns its length
+inline size_t format_temperature_data(
+        const Temperature& sample,
+        char *buffer,
+        size_t size)
+{
+    int length = snprintf(
+            buffer,
+            size,
+            "[sensor_id: %s, degrees: %d]",
+            sample.sensor_id,
+            static_cast<int>(sample.degrees));
+    return written_length(length, size);
+}
+
+inline void print_station_kind(StationKind station_kind)
+{
+    std::cout << station_kind_name(station_kind);
 }
 
 inline void print_lot_status_kind(LotStatusKind lot_status_kind)
 {
-    switch(lot_status_kind)
-    {
-    case WAITING:
-        std::cout << "WAITING";
-        break;
-    case PROCESSING:
-        std::cout << "PROCESSING";
-        break;
-    case COMPLETED:
-        std::cout << "COMPLETED";
-        break;
-    }
+    std::cout << lot_status_kind_name(lot_status_kind);
 }
 
 inline void print_chocolate_lot_data(const ChocolateLotState& sample)
 {
-    std::cout << "[" << "lot_id: " << sample.lot_id << ", " << "station: ";
-    print_station_kind(sample.station);
-    std::cout << ", next_station: ";
-    print_station_kind(sample.next_station);
-    std::cout << ", lot_status: ";
-    print_lot_status_kind(sample.lot_status);
-    std::cout << "]" << std::endl;
+    char text[SAMPLE_TEXT_SIZE];
+    size_t length = format_chocolate_lot_data(sample, text, sizeof(text));
+    std::cout.write(text, length) << std::endl;
 }
 
-}
\ No newline at end of file
+}
@@ -62,7 +62,7 @@ void process_lot(
         // No need to check that this is the next station: content filter
         // ensures that the reader only receives lots with
         // next_station == this station.
-        std::cout << "Processing lot #" << data_seq[i].lot_id << std::endl;
+        LogLine(LOG_LEVEL_INFO) << "Processing lot #" << data_seq[i].lot_id;
 
         // Send an update that the this station is processing lot
         ChocolateLotState updated_state(data_seq[i]);
@@ -88,6 +88,14 @@ void process_lot(
             std::cerr << "write error " << retcode << std::endl;
         }
 
+        // The lot is handed over to the next station: unregister it, so
+        // that the DataWriter does not keep every lot it has processed
+        retcode = lot_state_writer->unregister_instance(
+                updated_state,
+                DDS_HANDLE_NIL);
+        if (retcode != DDS_RETCODE_OK) {
+            std::cerr << "unregister_instance error " << retcode << std::endl;
+        }
     }
 
     // Data sequence was loaned from middleware for performance.
@@ -126,7 +134,10 @@ StationKind string_to_stationkind(const std::string& station_kind)
     return INVALID_CONTROLLER;
 }
 
-int run_example(unsigned int domain_id, const std::string& station_kind)
+int run_example(
+        unsigned int domain_id,
+        const std::string& station_kind,
+        const char *transport)
 {
     StationKind current_station = string_to_stationkind(station_kind);
     std::cout << station_kind << " station starting" << std::endl;
@@ -149,12 +160,10 @@ int run_example(unsigned int domain_id, const std::string& station_kind)
     // a DDS domain. Typically there is one DomainParticipant per application.
     // Uses IngredientApplication QoS profile to set participant name.
     DDSDomainParticipant *participant =
-            DDSTheParticipantFactory->create_participant_with_profile(
+            create_participant_with_transport(
                     domain_id,
-                    "ChocolateFactoryLibrary",
                     "IngredientApplication",
-                    NULL /* listener */,
-                    DDS_STATUS_MASK_NONE);
+                    transport);
     if (participant == NULL) {
         return shutdown(participant, "create_participant error", EXIT_FAILURE);
     }
@@ -290,7 +299,7 @@ int run_example(unsigned int domain_id, const std::string& station_kind)
     // ------------------------
     while (!shutdown_requested) {
         // Wait for ChocolateLotState
-        std::cout << "Waiting for lot" << std::endl;
+        LogLine(LOG_LEVEL_INFO) << "Waiting for lot";
 
         // wait() blocks execution of the thread until one or more attached
         // Conditions become true, or until a user-specified timeout expires.
@@ -371,7 +380,13 @@ int main(int argc, char *argv[])
     // Sets Connext verbosity to help debugging
     NDDSConfigLogger::get_instance()->set_verbosity(arguments.verbosity);
 
-    int status = run_example(arguments.domain_id, arguments.station_kind);
+    // Writes the log messages of the data paths in the background
+    LogWriter log_writer(arguments.log_level);
+
+    int status = run_example(
+            arguments.domain_id,
+            arguments.station_kind,
+            arguments.transport);
 
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
@@ -48,11 +48,11 @@ void publish_start_lot(StartLotThreadData *thread_data)
         sample.lot_status = WAITING;
         sample.next_station = COCOA_BUTTER_CONTROLLER;
 
-        std::cout << std::endl
-                  << "Starting lot: " << std::endl
-                  << "[lot_id: " << sample.lot_id << " next_station: ";
-        chocolate_factory::print_station_kind(sample.next_station);
-        std::cout << "]" << std::endl;
+        LogLine(LOG_LEVEL_INFO)
+                << "\nStarting lot: \n[lot_id: " << sample.lot_id
+                << " next_station: "
+                << chocolate_factory::station_kind_name(sample.next_station)
+                << "]";
 
         // Send an update to station that there is a lot waiting for tempering
         DDS_ReturnCode_t retcode = writer->write(sample, DDS_HANDLE_NIL);
@@ -60,6 +60,13 @@ void publish_start_lot(StartLotThreadData *thread_data)
             std::cerr << "write error " << retcode << std::endl;
         }
 
+        // The lot is handed over to the first station: unregister it, so
+        // that the DataWriter does not keep every lot it has started
+        retcode = writer->unregister_instance(sample, DDS_HANDLE_NIL);
+        if (retcode != DDS_RETCODE_OK) {
+            std::cerr << "unregister_instance error " << retcode << std::endl;
+        }
+
         // Start a new lot every 10 seconds
         DDS_Duration_t send_period = { 30, 0 };
         NDDSUtility::sleep(send_period);
@@ -85,8 +92,15 @@ unsigned int monitor_lot_state(ChocolateLotStateDataReader *lot_state_reader)
     for (int i = 0; i < data_seq.length(); ++i) {
         // Check if a sample is an instance lifecycle event
         if (info_seq[i].valid_data) {
-            std::cout << "Received lot update:" << std::endl;
-            chocolate_factory::print_chocolate_lot_data(data_seq[i]);
+            if (AsyncLog::instance().enabled(LOG_LEVEL_INFO)) {
+                char text[chocolate_factory::SAMPLE_TEXT_SIZE];
+                chocolate_factory::format_chocolate_lot_data(
+                        data_seq[i],
+                        text,
+                        sizeof(text));
+                LogLine(LOG_LEVEL_INFO) << "Received lot update:";
+                LogLine(LOG_LEVEL_INFO) << text;
+            }
             samples_read++;
         } else {
             // Detect that a lot is complete because the instance is disposed
@@ -98,8 +112,8 @@ unsigned int monitor_lot_state(ChocolateLotStateDataReader *lot_state_reader)
                 lot_state_reader->get_key_value(
                         key_holder,
                         info_seq[i].instance_handle);
-                std::cout << "[lot_id: " << key_holder.lot_id
-                        << " is completed]" << std::endl;
+                LogLine(LOG_LEVEL_INFO) << "[lot_id: " << key_holder.lot_id
+                                        << " is completed]";
             }
         }
     }
@@ -132,19 +146,29 @@ void monitor_temperature(TemperatureDataReader *temperature_reader)
     for (int i = 0; i < data_seq.length(); ++i) {
         // Check if a sample is an instance lifecycle event
         if (!info_seq[i].valid_data) {
-            std::cout << "Received instance state notification" << std::endl;
+            LogLine(LOG_LEVEL_INFO) << "Received instance state notification";
             continue;
         }
         // Print data
-        std::cout << "Tempering temperature out of range: ";
-        TemperatureTypeSupport::print_data(&data_seq[i]);
+        if (AsyncLog::instance().enabled(LOG_LEVEL_WARNING)) {
+            char text[chocolate_factory::SAMPLE_TEXT_SIZE];
+            chocolate_factory::format_temperature_data(
+                    data_seq[i],
+                    text,
+                    sizeof(text));
+            LogLine(LOG_LEVEL_WARNING)
+                    << "Tempering temperature out of range: " << text;
+        }
     }
     // Data sequence was loaned from middleware for performance.
     // Return loan when application is finished with data.
     temperature_reader->return_loan(data_seq, info_seq);
 }
 
-int run_example(unsigned int domain_id, unsigned int sample_count)
+int run_example(
+        unsigned int domain_id,
+        unsigned int sample_count,
+        const char *transport)
 {
     // Connext DDS Setup
     // -----------------
@@ -165,12 +189,10 @@ int run_example(unsigned int domain_id, unsigned int sample_count)
     // DomainParticipant QoS is configured in USER_QOS_PROFILES.xml
     // Load DomainParticipant QoS profile
     DDSDomainParticipant *participant =
-        DDSTheParticipantFactory->create_participant_with_profile(
+        create_participant_with_transport(
                 domain_id,
-                "ChocolateFactoryLibrary",
                 "TemperingApplication",
-                NULL /* listener */,
-                DDS_STATUS_MASK_NONE);
+                transport);
     if (participant == NULL) {
         shutdown(participant, "create_participant error", EXIT_FAILURE);
     }
@@ -450,7 +472,13 @@ int main(int argc, char *argv[])
     // Sets Connext verbosity to help debugging
     NDDSConfigLogger::get_instance()->set_verbosity(arguments.verbosity);
 
-    int status = run_example(arguments.domain_id, arguments.sample_count);
+    // Writes the log messages of the data paths in the background
+    LogWriter log_writer(arguments.log_level);
+
+    int status = run_example(
+            arguments.domain_id,
+            arguments.sample_count,
+            arguments.transport);
 
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown
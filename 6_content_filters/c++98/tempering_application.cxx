@@ -51,7 +51,7 @@ void publish_temperature(const TemperatureWriteData *write_data)
         counter++;
         // Occasionally make the temperature high
         if (counter % 400 == 0) {
-            std::cout << "Temperature too high" << std::endl;
+            LogLine(LOG_LEVEL_WARNING) << "Temperature too high";
             temperature.degrees = 33;
         } else {
             snprintf(temperature.sensor_id, 255, "%s", write_data->sensor_id);
@@ -94,8 +94,8 @@ void process_lot(
             // Exercise #1.3: Remove the check that the Tempering Application
             // is the next_station. This will now be filtered automatically.
             if (data_seq[i].next_station == TEMPERING_CONTROLLER) {
-                std::cout << "Processing lot #" << data_seq[i].lot_id
-                        << std::endl;
+                LogLine(LOG_LEVEL_INFO)
+                        << "Processing lot #" << data_seq[i].lot_id;
 
                 // Send an update that the tempering station is processing lot
                 ChocolateLotState updated_state(data_seq[i]);
@@ -118,7 +118,20 @@ void process_lot(
                 retcode = lot_state_writer->dispose(
                         updated_state,
                         DDS_HANDLE_NIL);
-                std::cout << "Lot completed" << std::endl;
+                if (retcode != DDS_RETCODE_OK) {
+                    std::cerr << "dispose error " << retcode << std::endl;
+                }
+
+                // Unregister the completed lot, so that the DataWriter and
+                // the DataReaders can purge it
+                retcode = lot_state_writer->unregister_instance(
+                        updated_state,
+                        DDS_HANDLE_NIL);
+                if (retcode != DDS_RETCODE_OK) {
+                    std::cerr << "unregister_instance error " << retcode
+                              << std::endl;
+                }
+                LogLine(LOG_LEVEL_INFO) << "Lot completed";
             }
 
         } else {
@@ -152,7 +165,8 @@ void on_requested_incompatible_qos(DDSDataReader *reader)
 int run_example(
         unsigned int domain_id,
         unsigned int sample_count,
-        const char *sensor_id)
+        const char *sensor_id,
+        const char *transport)
 {
     // Load XML QoS from a specific file
     DDSDomainParticipantFactory *factory =
@@ -172,12 +186,10 @@ int run_example(
     // a DDS domain. Typically there is one DomainParticipant per application.
     // Uses TemperingApplication QoS profile to set participant name.
     DDSDomainParticipant *participant =
-            DDSTheParticipantFactory->create_participant_with_profile(
+            create_participant_with_transport(
                     domain_id,
-                    "ChocolateFactoryLibrary",
                     "TemperingApplication",
-                    NULL /* listener */,
-                    DDS_STATUS_MASK_NONE);
+                    transport);
     if (participant == NULL) {
         return shutdown(participant, "create_participant error", EXIT_FAILURE);
     }
@@ -348,7 +360,7 @@ int run_example(
     // ------------------------
     while (!shutdown_requested) {
         // Wait for ChocolateLotState
-        std::cout << "Waiting for lot" << std::endl;
+        LogLine(LOG_LEVEL_INFO) << "Waiting for lot";
 
         // wait() blocks execution of the thread until one or more attached
         // Conditions become true, or until a user-specified timeout expires.
@@ -430,10 +442,14 @@ int main(int argc, char *argv[])
     // Sets Connext verbosity to help debugging
     NDDSConfigLogger::get_instance()->set_verbosity(arguments.verbosity);
 
+    // Writes the log messages of the data paths in the background
+    LogWriter log_writer(arguments.log_level);
+
     int status = run_example(
             arguments.domain_id,
             arguments.sample_count,
-            arguments.sensor_id);
+            arguments.sensor_id,
+            arguments.transport);
 
     // Releases the memory used by the participant factory.  Optional at
     // application shutdown